@@ -0,0 +1,64 @@
+// Cost of BlurNode against radius for each blur method.
+// Usage: blur_benchmark [width height]
+#include "nodes/BlurNode.hpp"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+namespace {
+    // Median wall time of `runs` calls to process(), with the node's log silenced
+    double medianMilliseconds(BlurNode& node, int runs) {
+        std::ostringstream discard;
+        std::streambuf* previous = std::cout.rdbuf(discard.rdbuf());
+        std::vector<double> times;
+        for (int i = 0; i < runs; i++) {
+            auto start = std::chrono::steady_clock::now();
+            node.process();
+            times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        std::cout.rdbuf(previous);
+        std::sort(times.begin(), times.end());
+        return times[times.size() / 2];
+    }
+}
+
+int main(int argc, char** argv) {
+    int width = argc > 2 ? std::atoi(argv[1]) : 1920;
+    int height = argc > 2 ? std::atoi(argv[2]) : 1080;
+    const int runs = 7;
+
+    cv::Mat image(height, width, CV_8UC3);
+    cv::randu(image, cv::Scalar::all(0), cv::Scalar::all(256));
+
+    BlurNode separable("separable");
+    separable.setGaussianMethod(BlurNode::GaussianMethod::Separable);
+    BlurNode stackedBox("stacked_box");
+    stackedBox.setGaussianMethod(BlurNode::GaussianMethod::StackedBox);
+    BlurNode directional("directional");
+    directional.setDirectional(true);
+    directional.setAngle(30.0f);
+
+    std::vector<BlurNode*> nodes = {&separable, &stackedBox, &directional};
+    for (BlurNode* node : nodes) {
+        node->setInput(image);
+    }
+
+    std::cout << "BlurNode on " << width << "x" << height << " CV_8UC3, median of " << runs << " runs (ms)\n";
+    std::cout << std::setw(8) << "radius" << std::setw(14) << "separable" << std::setw(14) << "stacked box"
+              << std::setw(14) << "directional" << "\n";
+    std::cout << std::fixed << std::setprecision(2);
+    for (int radius : {1, 2, 4, 8, 16, 32, 64}) {
+        std::cout << std::setw(8) << radius;
+        for (BlurNode* node : nodes) {
+            node->setRadius(radius);
+            std::cout << std::setw(14) << medianMilliseconds(*node, runs);
+        }
+        std::cout << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,99 @@
+// ConvolutionFilterNode's integer paths against filter2D on 8-bit images, with a check
+// that both give identical output.
+// Usage: convolution_benchmark [width height]
+#include "nodes/ConvolutionFilterNode.hpp"
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+    // Median wall time of `runs` calls
+    double medianMilliseconds(const std::function<void()>& function, int runs) {
+        std::vector<double> times;
+        for (int i = 0; i < runs; i++) {
+            auto start = std::chrono::steady_clock::now();
+            function();
+            times.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        std::sort(times.begin(), times.end());
+        return times[times.size() / 2];
+    }
+
+    const char* methodName(ConvolutionFilterNode::Method method) {
+        switch (method) {
+            case ConvolutionFilterNode::Method::Direct: return "direct";
+            case ConvolutionFilterNode::Method::Integer: return "integer";
+            case ConvolutionFilterNode::Method::Separable: return "separable";
+            case ConvolutionFilterNode::Method::LowRank: return "low-rank";
+            case ConvolutionFilterNode::Method::FFT: return "fft";
+        }
+        return "?";
+    }
+}
+
+int main(int argc, char** argv) {
+    int width = argc > 2 ? std::atoi(argv[1]) : 1920;
+    int height = argc > 2 ? std::atoi(argv[2]) : 1080;
+    const int runs = 9;
+
+    cv::Mat image(height, width, CV_8UC3);
+    cv::randu(image, cv::Scalar::all(0), cv::Scalar::all(256));
+
+    struct Case {
+        std::string name;
+        ConvolutionFilterNode::PresetType preset;
+        int size;
+        std::vector<float> weights;
+    };
+    std::vector<Case> cases = {
+        {"sharpen 3x3", ConvolutionFilterNode::PresetType::Sharpen, 3, {}},
+        {"emboss 3x3", ConvolutionFilterNode::PresetType::Emboss, 3, {}},
+        {"laplacian 5x5", ConvolutionFilterNode::PresetType::Custom, 5,
+         {0, 0, -1, 0, 0, 0, -1, -2, -1, 0, -1, -2, 17, -2, -1, 0, -1, -2, -1, 0, 0, 0, -1, 0, 0}},
+        {"box 7x7", ConvolutionFilterNode::PresetType::Custom, 7, std::vector<float>(49, 1.0f)},
+    };
+
+    std::cout << "ConvolutionFilterNode on " << width << "x" << height << " CV_8UC3, median of " << runs
+              << " runs (ms)\n";
+    std::cout << std::setw(16) << "kernel" << std::setw(12) << "method" << std::setw(12) << "node"
+              << std::setw(12) << "filter2D" << std::setw(12) << "max diff" << "\n";
+    std::cout << std::fixed << std::setprecision(2);
+    for (const Case& c : cases) {
+        ConvolutionFilterNode node("bench", c.name);
+        if (c.preset == ConvolutionFilterNode::PresetType::Custom) {
+            node.setKernelSize(c.size);
+            node.setCustomKernel(c.weights);
+        } else {
+            node.setPreset(c.preset);
+        }
+        node.setInput(image);
+
+        std::vector<float> weights = c.weights;
+        if (weights.empty()) {
+            const float sharpen[9] = {0, -1, 0, -1, 5, -1, 0, -1, 0};
+            const float emboss[9] = {-2, -1, 0, -1, 1, 1, 0, 1, 2};
+            const float* preset = c.preset == ConvolutionFilterNode::PresetType::Sharpen ? sharpen : emboss;
+            weights.assign(preset, preset + 9);
+        }
+        cv::Mat kernel(c.size, c.size, CV_32F, weights.data());
+        cv::Mat reference;
+
+        double nodeTime = medianMilliseconds([&] { node.process(); }, runs);
+        double directTime = medianMilliseconds([&] { cv::filter2D(image, reference, -1, kernel); }, runs);
+
+        cv::Mat difference;
+        cv::absdiff(node.getOutput(), reference, difference);
+        double maxDifference = 0.0;
+        cv::minMaxLoc(difference.reshape(1), nullptr, &maxDifference);
+
+        std::cout << std::setw(16) << c.name << std::setw(12) << methodName(node.getMethod()) << std::setw(12)
+                  << nodeTime << std::setw(12) << directTime << std::setw(12) << maxDifference << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,126 @@
+#include "HistogramService.hpp"
+#include <algorithm>
+#include <cfloat>
+#include <iostream>
+
+namespace {
+    bool sameBuffer(const cv::Mat& a, const cv::Mat& b) {
+        return a.data == b.data && a.size() == b.size() && a.type() == b.type() && a.step == b.step;
+    }
+}
+
+HistogramService& HistogramService::instance() {
+    static HistogramService service;
+    return service;
+}
+
+uint64_t HistogramService::nextVersion() {
+    static std::atomic<uint64_t> counter{0};
+    return ++counter;
+}
+
+HistogramService::Histogram HistogramService::get(const cv::Mat& image, uint64_t version) {
+    if (image.empty() || image.type() != CV_8UC1) {
+        std::cerr << "HistogramService requires a non-empty 8-bit single-channel image" << std::endl;
+        return Histogram(256, 0);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto it = entries.begin(); it != entries.end(); ++it) {
+            if (it->version == version && sameBuffer(it->image, image)) {
+                entries.splice(entries.begin(), entries, it);
+                return entries.front().histogram;
+            }
+        }
+    }
+
+    // Compute outside the lock; two callers racing on the same image just store it twice
+    Histogram histogram = compute(image);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.push_front({image, version, histogram});
+    if (entries.size() > maxEntries) {
+        entries.pop_back();
+    }
+    return histogram;
+}
+
+HistogramService::Histogram HistogramService::compute(const cv::Mat& image) {
+    Histogram total(256, 0);
+    std::mutex totalMutex;
+
+    cv::parallel_for_(cv::Range(0, image.rows), [&](const cv::Range& band) {
+        // Four interleaved sub-histograms, so runs of equal pixels do not serialize on one counter
+        std::vector<uint32_t> counts(4 * 256, 0);
+        uint32_t* c0 = counts.data();
+        uint32_t* c1 = c0 + 256;
+        uint32_t* c2 = c1 + 256;
+        uint32_t* c3 = c2 + 256;
+
+        for (int y = band.start; y < band.end; ++y) {
+            const uchar* row = image.ptr<uchar>(y);
+            int x = 0;
+            for (; x + 4 <= image.cols; x += 4) {
+                c0[row[x]]++;
+                c1[row[x + 1]]++;
+                c2[row[x + 2]]++;
+                c3[row[x + 3]]++;
+            }
+            for (; x < image.cols; ++x) {
+                c0[row[x]]++;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(totalMutex);
+        for (int i = 0; i < 256; ++i) {
+            total[i] += static_cast<int>(c0[i] + c1[i] + c2[i] + c3[i]);
+        }
+    });
+
+    return total;
+}
+
+int HistogramService::otsuThreshold(const Histogram& histogram) {
+    // Mirrors OpenCV's getThreshVal_Otsu_8u so the chosen level is identical
+    double pixelCount = 0;
+    double mu = 0;
+    for (int i = 0; i < 256; ++i) {
+        pixelCount += histogram[i];
+        mu += i * static_cast<double>(histogram[i]);
+    }
+    if (pixelCount == 0) {
+        return 0;
+    }
+
+    const double scale = 1.0 / pixelCount;
+    mu *= scale;
+
+    double mu1 = 0, q1 = 0;
+    double maxSigma = 0;
+    int maxLevel = 0;
+    for (int i = 0; i < 256; ++i) {
+        double p = histogram[i] * scale;
+        mu1 *= q1;
+        q1 += p;
+        double q2 = 1.0 - q1;
+
+        if (std::min(q1, q2) < FLT_EPSILON || std::max(q1, q2) > 1.0 - FLT_EPSILON) {
+            continue;
+        }
+
+        mu1 = (mu1 + i * p) / q1;
+        double mu2 = (mu - q1 * mu1) / q2;
+        double sigma = q1 * q2 * (mu1 - mu2) * (mu1 - mu2);
+        if (sigma > maxSigma) {
+            maxSigma = sigma;
+            maxLevel = i;
+        }
+    }
+    return maxLevel;
+}
+
+void HistogramService::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <vector>
+
+// Shared, thread-safe store of 256-bin histograms of 8-bit single-channel images.
+// Entries are keyed on buffer identity plus a version the owner takes from
+// nextVersion() whenever it writes into the buffer, so the UI and processing code
+// of a node can ask for the same histogram every frame and it is only computed
+// once per input change. Versions are unique process-wide, so two owners can
+// never present the same buffer and version for different contents.
+//
+// An entry keeps a reference to its image, so the buffer cannot be freed and reused
+// under the same address while it is cached; only the few most recent are kept.
+class HistogramService {
+public:
+    using Histogram = std::vector<int>;
+
+    static HistogramService& instance();
+
+    // A version no other caller has been given
+    static uint64_t nextVersion();
+
+    // The histogram of `image` (CV_8UC1) at `version`, computed on the first request
+    Histogram get(const cv::Mat& image, uint64_t version);
+
+    // Computes a histogram in parallel row bands, each band counting into its own
+    // interleaved sub-histograms before they are summed
+    static Histogram compute(const cv::Mat& image);
+
+    // Otsu's threshold from a histogram, selecting the same level as cv::THRESH_OTSU
+    static int otsuThreshold(const Histogram& histogram);
+
+    void clear();
+
+private:
+    struct Entry {
+        cv::Mat image;
+        uint64_t version;
+        Histogram histogram;
+    };
+
+    static constexpr size_t maxEntries = 4;
+
+    std::list<Entry> entries;  // Most recently used at the front
+    std::mutex mutex;
+};
@@ -0,0 +1,36 @@
+#include "LookupTable.hpp"
+#include <iostream>
+
+LookupTable::LookupTable() : table(1, 256, CV_8U) {
+    uchar* entries = table.ptr<uchar>();
+    for (int i = 0; i < 256; i++) {
+        entries[i] = static_cast<uchar>(i);
+    }
+}
+
+LookupTable LookupTable::linear(double alpha, double beta) {
+    // convertTo scales 8-bit data in single precision, so the table does too
+    const float scale = static_cast<float>(alpha);
+    const float shift = static_cast<float>(beta);
+    return fromFunction([scale, shift](int value) { return static_cast<float>(value) * scale + shift; });
+}
+
+LookupTable LookupTable::then(const LookupTable& next) const {
+    LookupTable composed;
+    const uchar* first = table.ptr<uchar>();
+    const uchar* second = next.table.ptr<uchar>();
+    uchar* entries = composed.table.ptr<uchar>();
+    for (int i = 0; i < 256; i++) {
+        entries[i] = second[first[i]];
+    }
+    return composed;
+}
+
+bool LookupTable::apply(const cv::Mat& src, cv::Mat& dst) const {
+    if (src.depth() != CV_8U) {
+        std::cerr << "LookupTable can only be applied to 8-bit images" << std::endl;
+        return false;
+    }
+    cv::LUT(src, table, dst);
+    return true;
+}
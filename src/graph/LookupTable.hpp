@@ -0,0 +1,37 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+
+// 256-entry table for 8-bit point operations: any per-sample mapping of an 8-bit
+// image, however it is computed, reduces to one table and one cv::LUT pass. Tables
+// compose, so a chain of point operations costs a single pass over the image.
+class LookupTable {
+public:
+    // The identity mapping
+    LookupTable();
+
+    // Builds a table from f(value), saturating each result to [0, 255]
+    template <typename Function>
+    static LookupTable fromFunction(Function f) {
+        LookupTable lut;
+        uchar* entries = lut.table.ptr<uchar>();
+        for (int i = 0; i < 256; i++) {
+            entries[i] = cv::saturate_cast<uchar>(f(i));
+        }
+        return lut;
+    }
+
+    // value * alpha + beta, rounded and saturated exactly like Mat::convertTo on 8-bit images
+    static LookupTable linear(double alpha, double beta);
+
+    // The table applying this mapping first and `next` to its result
+    LookupTable then(const LookupTable& next) const;
+
+    // Maps every sample of an 8-bit image, whatever its channel count
+    bool apply(const cv::Mat& src, cv::Mat& dst) const;
+
+    uchar operator[](int value) const { return table.at<uchar>(value); }
+    const cv::Mat& getTable() const { return table; }
+
+private:
+    cv::Mat table;  // 1x256 CV_8U
+};
@@ -3,6 +3,9 @@
 #include <opencv2/opencv.hpp>
 #include <vector>
 #include <memory>
+#include <cstdint>
+#include "LookupTable.hpp"
+#include "PlanarImage.hpp"
 
 class Node {
 public:
@@ -12,10 +15,89 @@ public:
     virtual void process() = 0;  
     virtual void renderUI() = 0;  
     virtual cv::Mat getOutput() const = 0;  
-    virtual void setInput(const cv::Mat& input) { this->input = input; }  
+
+    // Number of output ports; port 0 is getOutput()
+    virtual int getOutputCount() const { return 1; }
+
+    // The image on a numbered output port. Nodes with several outputs may build the
+    // extra ones on demand, so ports nothing reads cost nothing; such nodes should
+    // return no cache key, since the result cache only stores port 0.
+    virtual cv::Mat getOutputAt(int port) const { return getOutput(); }
+    // Every input setter flags the node dirty, so a root fed a new image directly is
+    // recomputed on the next evaluation; overrides must call invalidate() as well
+    virtual void setInput(const cv::Mat& input) { this->input = input; invalidate(); }
+
+    // Routes an image to a numbered input port; single-input nodes ignore the port
+    virtual void setInputAt(int port, const cv::Mat& input) { setInput(input); }
 
     cv::Mat getInput() const { return input; }
 
+    // Serialized parameters that, together with the inputs, fully determine the
+    // output. An empty key (the default) marks the node as uncacheable, e.g.
+    // because process() has side effects such as writing files.
+    virtual std::string getCacheKey() const { return ""; }
+
+    // Every input image the node reads, in port order, for nodes whose inputs may be
+    // handed over directly (setInput and friends) instead of through connections.
+    // NodeGraph hashes them into the cache key when connections do not cover every
+    // input. Returns false if the node cannot list them; it is then only cached when
+    // fed by connections.
+    virtual bool getInputImages(std::vector<cv::Mat>& images) const { return false; }
+
+    // Installs a previously computed output instead of running process();
+    // every node that returns a cache key must override this
+    virtual void setOutput(const cv::Mat& output) {}
+
+    // True if, for this input, every output sample is a function of the input sample
+    // at the same position alone and the output has the input's type and size.
+    // NodeGraph fuses chains of such nodes into a single pass over the image.
+    virtual bool isPointOperation(const cv::Mat& input) const { return false; }
+
+    // Point operations: true if the node reads its input outside process(), for example
+    // to plot it in renderUI. Fused members normally never receive their input; for
+    // these NodeGraph materializes it from the part of the chain in front of them.
+    virtual bool needsInputWhenFused() const { return false; }
+
+    // Point operations: maps a row of float samples in place, as process() would
+    virtual void applyPointRow(float* values, int length) const {}
+
+    // Point operations: the same mapping as a table for 8-bit input
+    virtual LookupTable pointLUT() const {
+        float values[256];
+        for (int i = 0; i < 256; i++) {
+            values[i] = static_cast<float>(i);
+        }
+        applyPointRow(values, 256);
+        return LookupTable::fromFunction([&values](int value) { return values[value]; });
+    }
+
+    // Layout negotiation: true if the node processes each channel independently and
+    // accepts planar input and produces planar output. NodeGraph passes PlanarImage
+    // along an edge only when both ends support it; everywhere else images stay
+    // interleaved, so nodes that do not opt in never see a planar image.
+    virtual bool supportsPlanar() const { return false; }
+
+    // Planar nodes: receives a planar image on an input port, replacing any interleaved input
+    virtual void setPlanarInputAt(int port, const PlanarImage& input) {}
+
+    // Planar nodes: the output when planar output was requested
+    virtual PlanarImage getPlanarOutput() const { return PlanarImage(); }
+
+    // Set by NodeGraph before process(): every consumer takes planar input, so the
+    // node should keep its result planar; getOutput() then interleaves on demand
+    void setPlanarOutputRequested(bool planar) { planarOutputRequested = planar; }
+    bool isPlanarOutputRequested() const { return planarOutputRequested; }
+
+    // Called on every parameter change: bumps the version and flags the output as stale
+    void markDirty() { ++version; dirty = true; }
+
+    // Flags the output as stale without a parameter change (an upstream node changed)
+    void invalidate() { dirty = true; }
+
+    void clearDirty() { dirty = false; }
+    bool isDirty() const { return dirty; }
+    uint64_t getVersion() const { return version; }
+
     virtual ~Node() = default; 
 
 protected:
@@ -23,4 +105,9 @@ protected:
 
     enum class NodeType { Input, Processing, Output };
     NodeType nodeType; 
+
+private:
+    bool dirty = true;     // Nothing has been computed yet
+    uint64_t version = 0;  // Parameter revision, incremented by markDirty()
+    bool planarOutputRequested = false;
 };
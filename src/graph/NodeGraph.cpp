@@ -1,32 +1,582 @@
 #include "NodeGraph.hpp"
 #include <iostream>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <mutex>
+#include <queue>
+#include <set>
+#include <sstream>
+#include <typeinfo>
+#include <unordered_map>
+#include <functional>
+
+namespace {
+    double millisecondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+}
 
 void NodeGraph::addNode(const std::shared_ptr<Node>& node) {
     nodes.push_back(node);
 }
 
-void NodeGraph::connectNodes(const std::shared_ptr<Node>& fromNode, const std::shared_ptr<Node>& toNode) {
+void NodeGraph::connectNodes(const std::shared_ptr<Node>& fromNode, const std::shared_ptr<Node>& toNode, int inputPort,
+                             int outputPort) {
     if (std::find(nodes.begin(), nodes.end(), fromNode) != nodes.end() &&
         std::find(nodes.begin(), nodes.end(), toNode) != nodes.end()) {
-        connections.push_back(std::make_pair(fromNode, toNode));
+        if (outputPort < 0 || outputPort >= fromNode->getOutputCount()) {
+            std::cerr << "Invalid output port " << outputPort << " on node " << fromNode->name << "!" << std::endl;
+            return;
+        }
+        connections.push_back({fromNode, toNode, inputPort, outputPort});
+        toNode->invalidate();  // The consumer has a new input to pick up
+        if (fusedAway.count(fromNode.get())) {
+            fromNode->invalidate();  // Its output was fused away and must exist for the new consumer
+        }
     } else {
         std::cerr << "Invalid node connection!" << std::endl;
     }
 }
 
+void NodeGraph::setWorkerCount(size_t count) {
+    if (count == 0) {
+        count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (count != workerCount) {
+        pool.reset();
+    }
+    workerCount = count;
+}
+
+size_t NodeGraph::getWorkerCount() const {
+    return workerCount;
+}
+
+const NodeGraph::RunStats& NodeGraph::getLastRunStats() const {
+    return lastRunStats;
+}
+
+void NodeGraph::enableResultCache(size_t budgetBytes, const std::string& diskDirectory) {
+    if (resultCache) {
+        resultCache->setBudget(budgetBytes);
+    } else {
+        resultCache = std::make_unique<ResultCache>(budgetBytes);
+    }
+    resultCache->setDiskDirectory(diskDirectory);
+}
+
+void NodeGraph::disableResultCache() {
+    resultCache.reset();
+    outputHashes.clear();
+}
+
+ResultCache::Stats NodeGraph::getCacheStats() const {
+    return resultCache ? resultCache->getStats() : ResultCache::Stats();
+}
+
+bool NodeGraph::buildExecutionPlan(ExecutionPlan& plan) const {
+    std::unordered_map<const Node*, size_t> indexOf;
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        indexOf[nodes[i].get()] = i;
+    }
+
+    plan.incoming.assign(nodes.size(), {});
+    plan.consumers.assign(nodes.size(), {});
+    plan.sources.assign(connections.size(), 0);
+
+    // Kahn's algorithm; ready nodes are taken in insertion order so the
+    // schedule is deterministic for a given graph
+    std::vector<size_t> inDegree(nodes.size(), 0);
+    for (size_t c = 0; c < connections.size(); ++c) {
+        size_t from = indexOf.at(connections[c].from.get());
+        size_t to = indexOf.at(connections[c].to.get());
+        plan.incoming[to].push_back(c);
+        plan.consumers[from].push_back(to);
+        plan.sources[c] = from;
+        inDegree[to]++;
+    }
+
+    std::priority_queue<size_t, std::vector<size_t>, std::greater<size_t>> ready;
+    plan.roots.clear();
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        if (inDegree[i] == 0) {
+            ready.push(i);
+            plan.roots.push_back(i);
+        }
+    }
+
+    plan.order.clear();
+    plan.order.reserve(nodes.size());
+    while (!ready.empty()) {
+        size_t current = ready.top();
+        ready.pop();
+        plan.order.push_back(current);
+        for (size_t next : plan.consumers[current]) {
+            if (--inDegree[next] == 0) {
+                ready.push(next);
+            }
+        }
+    }
+
+    // Layout negotiation: a node keeps its result planar only if every consumer accepts planes
+    plan.planarOutput.assign(nodes.size(), false);
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        bool planar = nodes[i]->supportsPlanar() && nodes[i]->getOutputCount() == 1 && !plan.consumers[i].empty();
+        for (size_t consumer : plan.consumers[i]) {
+            planar = planar && nodes[consumer]->supportsPlanar();
+        }
+        plan.planarOutput[i] = planar;
+    }
+
+    return plan.order.size() == nodes.size();
+}
+
+void NodeGraph::propagateDirty(const ExecutionPlan& plan) {
+    // Producers precede consumers in the order, so one sweep reaches the whole cone
+    for (size_t index : plan.order) {
+        if (nodes[index]->isDirty()) {
+            for (size_t consumer : plan.consumers[index]) {
+                nodes[consumer]->invalidate();
+            }
+        }
+    }
+}
+
+void NodeGraph::rematerializeInputs(const ExecutionPlan& plan) {
+    // Consumers precede producers in reverse order, so a chain is walked back to its start
+    bool changed = false;
+    for (auto it = plan.order.rbegin(); it != plan.order.rend(); ++it) {
+        if (!nodes[*it]->isDirty()) {
+            continue;
+        }
+        for (size_t c : plan.incoming[*it]) {
+            const auto& producer = nodes[plan.sources[c]];
+            if (!producer->isDirty() && fusedAway.count(producer.get())) {
+                producer->invalidate();
+                changed = true;
+            }
+        }
+    }
+    if (changed) {
+        propagateDirty(plan);
+    }
+}
+
+void NodeGraph::markDirty(const std::shared_ptr<Node>& node) {
+    node->markDirty();
+
+    std::vector<const Node*> visited = {node.get()};
+    std::vector<std::shared_ptr<Node>> pending = {node};
+    while (!pending.empty()) {
+        std::shared_ptr<Node> current = pending.back();
+        pending.pop_back();
+        for (const auto& connection : connections) {
+            if (connection.from == current &&
+                std::find(visited.begin(), visited.end(), connection.to.get()) == visited.end()) {
+                connection.to->invalidate();
+                visited.push_back(connection.to.get());
+                pending.push_back(connection.to);
+            }
+        }
+    }
+}
+
+void NodeGraph::markAllDirty() {
+    for (auto& node : nodes) {
+        node->invalidate();
+    }
+}
+
+void NodeGraph::gatherInputs(const ExecutionPlan& plan, size_t index) {
+    for (size_t c : plan.incoming[index]) {
+        const Connection& connection = connections[c];
+        if (plan.planarOutput[plan.sources[c]]) {
+            connection.to->setPlanarInputAt(connection.inputPort, connection.from->getPlanarOutput());
+        } else {
+            connection.to->setInputAt(connection.inputPort, connection.from->getOutputAt(connection.outputPort));
+        }
+    }
+}
+
+uint64_t NodeGraph::getOutputHash(size_t index, int port) {
+    const Node* node = nodes[index].get();
+    {
+        std::lock_guard<std::mutex> lock(outputHashMutex);
+        auto found = outputHashes.find(node);
+        if (found != outputHashes.end()) {
+            auto portHash = found->second.find(port);
+            if (portHash != found->second.end()) {
+                return portHash->second;
+            }
+        }
+    }
+
+    // Hash outside the lock; two consumers racing here just compute the same value
+    uint64_t hash = ResultCache::hashImage(node->getOutputAt(port));
+    std::lock_guard<std::mutex> lock(outputHashMutex);
+    outputHashes[node][port] = hash;
+    return hash;
+}
+
+std::string NodeGraph::buildCacheKey(const ExecutionPlan& plan, size_t index) {
+    const auto& node = nodes[index];
+    std::string parameters = node->getCacheKey();
+    if (parameters.empty() || plan.planarOutput[index]) {
+        return "";
+    }
+    for (size_t c : plan.incoming[index]) {
+        if (plan.planarOutput[plan.sources[c]]) {
+            return "";  // Hashing planar inputs would mean interleaving them first
+        }
+    }
+
+    std::ostringstream key;
+    key << typeid(*node).name() << '|' << parameters;
+    for (size_t c : plan.incoming[index]) {
+        const Connection& connection = connections[c];
+        key << '|' << connection.inputPort << ':' << connection.outputPort << ':' << std::hex
+            << getOutputHash(plan.sources[c], connection.outputPort) << std::dec;
+    }
+
+    // Inputs set with setInput() are invisible to the connection hashes above; a
+    // node with ports left unconnected must hash its own images or go uncached
+    std::set<int> connectedPorts;
+    for (size_t c : plan.incoming[index]) {
+        connectedPorts.insert(connections[c].inputPort);
+    }
+    std::vector<cv::Mat> images;
+    if (!node->getInputImages(images)) {
+        return connectedPorts.empty() ? "" : key.str();
+    }
+    if (connectedPorts.size() < images.size()) {
+        key << "|direct";
+        for (const cv::Mat& image : images) {
+            key << ':' << std::hex << ResultCache::hashImage(image) << std::dec;
+        }
+    }
+    return key.str();
+}
+
+std::vector<size_t> NodeGraph::collectPointChain(const ExecutionPlan& plan, size_t index,
+                                                 const cv::Mat& input) const {
+    std::vector<size_t> chain = {index};
+    if (input.empty() || (input.depth() != CV_8U && input.depth() != CV_32F) ||
+        !nodes[index]->isPointOperation(input)) {
+        return chain;
+    }
+
+    // Point operations keep the input type, so every link sees an image like `input`.
+    // Links must form a straight line: an intermediate output nobody else reads.
+    while (plan.consumers[chain.back()].size() == 1) {
+        size_t next = plan.consumers[chain.back()].front();
+        if (plan.incoming[next].size() != 1 || !nodes[next]->isDirty() || !nodes[next]->isPointOperation(input)) {
+            break;
+        }
+        chain.push_back(next);
+    }
+    return chain;
+}
+
+void NodeGraph::applyPointChain(const std::vector<size_t>& chain, size_t count, const cv::Mat& input,
+                                cv::Mat& result) const {
+    if (input.depth() == CV_8U) {
+        LookupTable composed;
+        for (size_t i = 0; i < count; ++i) {
+            composed = composed.then(nodes[chain[i]]->pointLUT());
+        }
+        composed.apply(input, result);
+    } else {
+        // Every node is applied to a row while it is still in cache
+        result.create(input.size(), input.type());
+        const int rowLength = input.cols * input.channels();
+        cv::parallel_for_(cv::Range(0, input.rows), [&](const cv::Range& rows) {
+            for (int y = rows.start; y < rows.end; ++y) {
+                float* row = result.ptr<float>(y);
+                std::copy(input.ptr<float>(y), input.ptr<float>(y) + rowLength, row);
+                for (size_t i = 0; i < count; ++i) {
+                    nodes[chain[i]]->applyPointRow(row, rowLength);
+                }
+            }
+        });
+    }
+}
+
+std::string NodeGraph::buildChainCacheKey(const ExecutionPlan& plan, const std::vector<size_t>& chain) {
+    if (plan.planarOutput[chain.back()]) {
+        return "";
+    }
+    std::string head = buildCacheKey(plan, chain.front());
+    if (head.empty()) {
+        return "";
+    }
+
+    std::ostringstream key;
+    key << head;
+    for (size_t i = 1; i < chain.size(); ++i) {
+        const auto& node = nodes[chain[i]];
+        std::string parameters = node->getCacheKey();
+        if (parameters.empty()) {
+            return "";
+        }
+        key << "|>" << typeid(*node).name() << '|' << parameters;
+    }
+    return key.str();
+}
+
+bool NodeGraph::executePointChain(const ExecutionPlan& plan, const std::vector<size_t>& chain,
+                                  const cv::Mat& input) {
+    // Members that keep their input (UI plots, statistics) get it from the chain in front of them
+    for (size_t i = 1; i < chain.size(); ++i) {
+        const auto& node = nodes[chain[i]];
+        if (node->needsInputWhenFused()) {
+            cv::Mat partial;
+            applyPointChain(chain, i, input, partial);
+            node->setInputAt(connections[plan.incoming[chain[i]].front()].inputPort, partial);
+        }
+    }
+
+    bool fromCache = false;
+    std::string key = resultCache ? buildChainCacheKey(plan, chain) : "";
+    cv::Mat result;
+    if (!key.empty() && resultCache->lookup(key, result)) {
+        fromCache = true;
+    } else {
+        applyPointChain(chain, chain.size(), input, result);
+        if (!key.empty()) {
+            resultCache->insert(key, result);
+        }
+    }
+
+    std::ostringstream log;
+    log << (fromCache ? "Fused point operations (cached):" : "Fused point operations:");
+    for (size_t i = 0; i < chain.size(); ++i) {
+        const auto& node = nodes[chain[i]];
+        log << (i == 0 ? " " : " -> ") << node->name;
+        if (i + 1 < chain.size()) {
+            node->setOutput(cv::Mat());  // Drop the stale intermediate
+        }
+        node->clearDirty();
+    }
+    nodes[chain.back()]->setOutput(result);
+    std::cout << log.str() << std::endl;
+
+    std::lock_guard<std::mutex> lock(outputHashMutex);
+    for (size_t i = 0; i < chain.size(); ++i) {
+        const Node* node = nodes[chain[i]].get();
+        outputHashes.erase(node);
+        if (i + 1 < chain.size()) {
+            fusedAway.insert(node);
+        } else {
+            fusedAway.erase(node);
+        }
+    }
+    return fromCache;
+}
+
+bool NodeGraph::executeNode(const ExecutionPlan& plan, size_t index, std::vector<size_t>& fused) {
+    const auto& node = nodes[index];
+    gatherInputs(plan, index);
+
+    node->setPlanarOutputRequested(plan.planarOutput[index]);
+
+    fused.clear();
+    if (plan.incoming[index].size() == 1 && !plan.planarOutput[plan.sources[plan.incoming[index].front()]]) {
+        const Connection& connection = connections[plan.incoming[index].front()];
+        const cv::Mat input = connection.from->getOutputAt(connection.outputPort);
+        std::vector<size_t> chain = collectPointChain(plan, index, input);
+        if (chain.size() > 1) {
+            fused.assign(chain.begin() + 1, chain.end());
+            return executePointChain(plan, chain, input);
+        }
+    }
+
+    bool fromCache = false;
+    std::string key = resultCache ? buildCacheKey(plan, index) : "";
+    cv::Mat cached;
+    if (!key.empty() && resultCache->lookup(key, cached)) {
+        node->setOutput(cached);
+        fromCache = true;
+    } else {
+        node->process();
+        if (!key.empty()) {
+            resultCache->insert(key, node->getOutput());
+        }
+    }
+    node->clearDirty();
+
+    // The node has a new output; its hash is recomputed the next time a consumer asks
+    std::lock_guard<std::mutex> lock(outputHashMutex);
+    outputHashes.erase(node.get());
+    fusedAway.erase(node.get());
+    return fromCache;
+}
+
+bool NodeGraph::evaluate() {
+    ExecutionPlan plan;
+    if (!buildExecutionPlan(plan)) {
+        std::cerr << "Node graph contains a cycle, aborting evaluation!" << std::endl;
+        return false;
+    }
+
+    propagateDirty(plan);
+    rematerializeInputs(plan);
+
+    lastRunStats = RunStats();
+    lastRunStats.workerCount = workerCount;
+    auto start = std::chrono::steady_clock::now();
+
+    if (workerCount > 1 && nodes.size() > 1) {
+        evaluateParallel(plan);
+    } else {
+        evaluateSequential(plan);
+    }
+
+    lastRunStats.wallTimeMs = millisecondsSince(start);
+    return true;
+}
+
+void NodeGraph::evaluateSequential(const ExecutionPlan& plan) {
+    std::vector<bool> done(nodes.size(), false);
+    std::vector<size_t> fused;
+    for (size_t index : plan.order) {
+        const auto& node = nodes[index];
+        if (done[index]) {
+            continue;  // Already produced as part of a fused chain
+        }
+        if (!node->isDirty()) {
+            lastRunStats.nodesSkipped++;
+            continue;
+        }
+
+        auto nodeStart = std::chrono::steady_clock::now();
+        if (executeNode(plan, index, fused)) {
+            lastRunStats.nodesFromCache++;
+        } else {
+            lastRunStats.nodesExecuted += 1 + fused.size();
+        }
+        if (!fused.empty()) {
+            lastRunStats.nodesFused += 1 + fused.size();
+            for (size_t member : fused) {
+                done[member] = true;
+            }
+        }
+        lastRunStats.busyTimeMs += millisecondsSince(nodeStart);
+        lastRunStats.peakConcurrency = 1;
+    }
+}
+
+void NodeGraph::evaluateParallel(const ExecutionPlan& plan) {
+    if (!pool) {
+        pool = std::make_unique<ThreadPool>(workerCount);
+    }
+
+    // A node becomes ready once every producer feeding it has finished
+    std::vector<std::atomic<size_t>> remainingInputs(nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        remainingInputs[i].store(plan.incoming[i].size());
+    }
+
+    std::atomic<size_t> running{0};
+    std::atomic<size_t> peak{0};
+    std::atomic<size_t> executed{0};
+    std::atomic<size_t> skipped{0};
+    std::atomic<size_t> cached{0};
+    std::atomic<size_t> fusedCount{0};
+    std::atomic<long long> busyNanoseconds{0};
+    std::mutex errorMutex;
+    std::exception_ptr firstError;
+
+    std::function<void(size_t)> runNode = [&](size_t index) {
+        const auto& node = nodes[index];
+        size_t last = index;  // Last node produced by this task, the end of a fused chain
+
+        if (node->isDirty()) {
+            size_t nowRunning = ++running;
+            size_t previousPeak = peak.load();
+            while (nowRunning > previousPeak && !peak.compare_exchange_weak(previousPeak, nowRunning)) {
+            }
+
+            auto nodeStart = std::chrono::steady_clock::now();
+            bool fromCache = false;
+            std::vector<size_t> fused;
+            try {
+                // Only this task touches the node now, so inputs are delivered without locking.
+                // Fused chain members are only reachable through this node and are never scheduled.
+                fromCache = executeNode(plan, index, fused);
+            } catch (...) {
+                // Consumers of a failed node are never scheduled; the error is rethrown by evaluate()
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!firstError) {
+                    firstError = std::current_exception();
+                }
+                --running;
+                return;
+            }
+            busyNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - nodeStart).count();
+            if (fromCache) {
+                ++cached;
+            } else {
+                executed += 1 + fused.size();
+            }
+            if (!fused.empty()) {
+                fusedCount += 1 + fused.size();
+                last = fused.back();
+            }
+            --running;
+        } else {
+            ++skipped;
+        }
+
+        for (size_t consumer : plan.consumers[last]) {
+            if (--remainingInputs[consumer] == 0) {
+                pool->submit([&runNode, consumer] { runNode(consumer); });
+            }
+        }
+    };
+
+    // Roots come from the plan, not from remainingInputs: once tasks start, consumers
+    // they release also reach zero and would be submitted a second time
+    for (size_t root : plan.roots) {
+        pool->submit([&runNode, root] { runNode(root); });
+    }
+    pool->waitIdle();
+
+    lastRunStats.nodesExecuted = executed.load();
+    lastRunStats.nodesSkipped = skipped.load();
+    lastRunStats.nodesFromCache = cached.load();
+    lastRunStats.nodesFused = fusedCount.load();
+    lastRunStats.peakConcurrency = peak.load();
+    lastRunStats.busyTimeMs = busyNanoseconds.load() / 1.0e6;
+
+    if (firstError) {
+        std::rethrow_exception(firstError);
+    }
+}
+
 void NodeGraph::run() {
     std::cout << "Node graph running with " << nodes.size() << " nodes...\n";
 
-    for (auto& node : nodes) {
-        node->process();  
+    if (!evaluate()) {
+        return;
+    }
+
+    const RunStats& stats = lastRunStats;
+    std::cout << "Executed " << stats.nodesExecuted << " nodes (" << stats.nodesSkipped << " up to date) on "
+              << stats.workerCount << " worker(s) in " << stats.wallTimeMs << " ms (peak "
+              << stats.peakConcurrency << " concurrent, average parallelism " << stats.averageParallelism() << ")\n";
+    if (stats.nodesFused > 0) {
+        std::cout << stats.nodesFused << " nodes ran in fused point-operation chains\n";
     }
 
-    for (const auto& connection : connections) {
-        const auto& fromNode = connection.first;
-        const auto& toNode = connection.second;
-        
-        toNode->setInput(fromNode->getOutput());
+    if (resultCache) {
+        ResultCache::Stats cacheStats = resultCache->getStats();
+        std::cout << "Result cache: " << stats.nodesFromCache << " nodes restored, " << cacheStats.hits << " hits ("
+                  << cacheStats.diskHits << " from disk), " << cacheStats.misses << " misses, " << cacheStats.evictions
+                  << " evictions, " << cacheStats.diskWrites << " files written, " << cacheStats.entries << " entries ("
+                  << cacheStats.bytes << " of " << resultCache->getBudget() << " bytes)\n";
     }
 
     for (auto& node : nodes) {
@@ -37,6 +587,8 @@ void NodeGraph::run() {
 void NodeGraph::clear() {
     nodes.clear();
     connections.clear();
+    outputHashes.clear();
+    fusedAway.clear();
 }
 
 const std::vector<std::shared_ptr<Node>>& NodeGraph::getNodes() const {
@@ -1,20 +1,149 @@
 #pragma once
 #include <vector>
 #include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 #include "Node.hpp"
+#include "ResultCache.hpp"
+#include "ThreadPool.hpp"
 
 class NodeGraph {
 public:
+    // A directed edge: output port `outputPort` of `from` feeds input port `inputPort` of `to`
+    struct Connection {
+        std::shared_ptr<Node> from;
+        std::shared_ptr<Node> to;
+        int inputPort = 0;
+        int outputPort = 0;
+    };
+
+    // Timing and parallelism figures for the most recent evaluate()
+    struct RunStats {
+        size_t nodesExecuted = 0;
+        size_t nodesSkipped = 0;     // Clean nodes whose previous output was reused
+        size_t nodesFromCache = 0;   // Dirty nodes whose output came from the result cache
+        size_t nodesFused = 0;       // Executed nodes that ran as part of a fused point-operation chain
+        size_t workerCount = 1;
+        size_t peakConcurrency = 0;  // Most nodes observed processing at the same time
+        double wallTimeMs = 0.0;     // Elapsed time of the whole evaluation
+        double busyTimeMs = 0.0;     // Sum of the time spent inside process() across nodes
+
+        // Average number of nodes processing at once (busy time / wall time)
+        double averageParallelism() const { return wallTimeMs > 0.0 ? busyTimeMs / wallTimeMs : 0.0; }
+    };
+
     void addNode(const std::shared_ptr<Node>& node);
     void run();
 
-    void connectNodes(const std::shared_ptr<Node>& fromNode, const std::shared_ptr<Node>& toNode);
+    // Executes every dirty node exactly once in dependency order, handing each
+    // node the outputs of its producers right before it runs. Clean nodes keep
+    // their previous output, so only the cone downstream of a change is recomputed.
+    //
+    // Images travel as PlanarImage from a node whose consumers all support the
+    // planar layout (Node::supportsPlanar) and interleaved everywhere else.
+    // Planar results bypass the result cache.
+    //
+    // Linear chains of point operations (see Node::isPointOperation) are fused:
+    // 8-bit input goes through one composed lookup table, float input through one
+    // row loop applying every node. Only the last node of a fused chain holds an
+    // output; the others are recomputed from upstream if something needs them.
+    // Members that read their input outside process() (Node::needsInputWhenFused)
+    // are handed it, and the chain's output is cached under a key covering all members.
+    // Returns false if the graph contains a cycle.
+    bool evaluate();
+
+    // Records a parameter change on `node` and invalidates every transitive consumer
+    void markDirty(const std::shared_ptr<Node>& node);
+
+    // Invalidates every node so the next evaluate() recomputes the whole graph
+    void markAllDirty();
+
+    void connectNodes(const std::shared_ptr<Node>& fromNode, const std::shared_ptr<Node>& toNode, int inputPort = 0,
+                      int outputPort = 0);
+
+    // Number of worker threads used by evaluate(). With 1 (the default) nodes run
+    // on the calling thread; with more, every node whose inputs are ready is
+    // dispatched concurrently on a work-stealing pool. 0 picks the core count.
+    void setWorkerCount(size_t count);
+    size_t getWorkerCount() const;
+
+    const RunStats& getLastRunStats() const;
+
+    // Memoizes node outputs keyed on (node type, cache key, input content hashes)
+    // in an LRU cache holding at most `budgetBytes` of image data. With a
+    // `diskDirectory`, results are also persisted there as raw images and
+    // reloaded by later sessions.
+    void enableResultCache(size_t budgetBytes, const std::string& diskDirectory = "");
+    void disableResultCache();
+
+    // Hit/miss/eviction counters of the result cache (all zero when disabled)
+    ResultCache::Stats getCacheStats() const;
 
     void clear();
 
     const std::vector<std::shared_ptr<Node>>& getNodes() const;
 
 private:
+    // Adjacency of the graph expressed as indices into `nodes` / `connections`
+    struct ExecutionPlan {
+        std::vector<size_t> order;                     // Topological order
+        std::vector<std::vector<size_t>> incoming;     // Connections feeding each node
+        std::vector<std::vector<size_t>> consumers;    // Nodes fed by each node
+        std::vector<size_t> roots;                     // Nodes with no incoming connection
+        std::vector<size_t> sources;                   // Producing node of each connection
+        std::vector<bool> planarOutput;                // Node hands PlanarImage to all of its consumers
+    };
+
+    // Builds a topological order from the connection list; false on a cycle
+    bool buildExecutionPlan(ExecutionPlan& plan) const;
+
+    // Spreads dirtiness from every dirty node to all of its transitive consumers
+    void propagateDirty(const ExecutionPlan& plan);
+
+    // Pulls the current output of every producer into the node's input ports
+    void gatherInputs(const ExecutionPlan& plan, size_t index);
+
+    // Marks fused-away producers of dirty nodes dirty again so their outputs are rebuilt
+    void rematerializeInputs(const ExecutionPlan& plan);
+
+    // Runs a dirty node, or restores its output from the result cache; true on a cache hit.
+    // Point operations absorb the chain of point operations behind them; the absorbed
+    // nodes are returned in `fused`, in order.
+    bool executeNode(const ExecutionPlan& plan, size_t index, std::vector<size_t>& fused);
+
+    // The chain of dirty point operations starting at `index` for `input`, or just `index`
+    std::vector<size_t> collectPointChain(const ExecutionPlan& plan, size_t index, const cv::Mat& input) const;
+
+    // Produces the output of the chain's last node in one pass over `input`, or restores it
+    // from the result cache; true on a cache hit
+    bool executePointChain(const ExecutionPlan& plan, const std::vector<size_t>& chain, const cv::Mat& input);
+
+    // Applies chain[0, count) to `input` as one composed lookup table or one row loop
+    void applyPointChain(const std::vector<size_t>& chain, size_t count, const cv::Mat& input, cv::Mat& result) const;
+
+    // Key of the chain's last output: the first node's key (which hashes the chain input)
+    // followed by every member's parameters. Empty when any member is uncacheable.
+    std::string buildChainCacheKey(const ExecutionPlan& plan, const std::vector<size_t>& chain);
+
+    // Empty when the node is uncacheable
+    std::string buildCacheKey(const ExecutionPlan& plan, size_t index);
+
+    // Content hash of a node's current output on `port`, computed once per produced output
+    uint64_t getOutputHash(size_t index, int port);
+
+    void evaluateSequential(const ExecutionPlan& plan);
+    void evaluateParallel(const ExecutionPlan& plan);
+
     std::vector<std::shared_ptr<Node>> nodes; 
-    std::vector<std::pair<std::shared_ptr<Node>, std::shared_ptr<Node>>> connections;  
+    std::vector<Connection> connections;  
+
+    size_t workerCount = 1;
+    std::unique_ptr<ThreadPool> pool;
+    RunStats lastRunStats;
+
+    std::unique_ptr<ResultCache> resultCache;
+    std::unordered_map<const Node*, std::unordered_map<int, uint64_t>> outputHashes;  // Per output port
+    std::unordered_set<const Node*> fusedAway;  // Nodes inside a fused chain, holding no output
+    std::mutex outputHashMutex;                 // Guards outputHashes and fusedAway
 };
@@ -0,0 +1,27 @@
+#include "PlanarImage.hpp"
+
+PlanarImage PlanarImage::fromInterleaved(const cv::Mat& image) {
+    if (image.empty()) {
+        return PlanarImage();
+    }
+    if (image.channels() == 1) {
+        return PlanarImage({image});
+    }
+
+    std::vector<cv::Mat> planes;
+    cv::split(image, planes);
+    return PlanarImage(std::move(planes));
+}
+
+cv::Mat PlanarImage::toInterleaved() const {
+    if (empty()) {
+        return cv::Mat();
+    }
+    if (planes.size() == 1) {
+        return planes.front();
+    }
+
+    cv::Mat image;
+    cv::merge(planes, image);
+    return image;
+}
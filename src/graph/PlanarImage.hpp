@@ -0,0 +1,33 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+// An image stored as one single-channel cv::Mat per channel (structure of arrays)
+// instead of interleaved BGR(A) samples. Channel-wise filters run on each plane
+// with unit stride and no split/merge in between, so NodeGraph keeps data in this
+// layout along edges where both ends accept it (see Node::supportsPlanar) and
+// interleaves only where a node needs a regular cv::Mat.
+class PlanarImage {
+public:
+    PlanarImage() = default;
+    explicit PlanarImage(std::vector<cv::Mat> planes) : planes(std::move(planes)) {}
+
+    // Splits an interleaved image; a single-channel image is shared, not copied
+    static PlanarImage fromInterleaved(const cv::Mat& image);
+
+    // Merges the planes back into one interleaved image; a single plane is shared, not copied
+    cv::Mat toInterleaved() const;
+
+    bool empty() const { return planes.empty() || planes.front().empty(); }
+    int channels() const { return static_cast<int>(planes.size()); }
+    cv::Size size() const { return empty() ? cv::Size() : planes.front().size(); }
+    int depth() const { return empty() ? -1 : planes.front().depth(); }
+
+    const cv::Mat& plane(int index) const { return planes[index]; }
+    cv::Mat& plane(int index) { return planes[index]; }
+
+    void release() { planes.clear(); }
+
+private:
+    std::vector<cv::Mat> planes;
+};
@@ -0,0 +1,333 @@
+#include "ResultCache.hpp"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+
+namespace {
+    size_t imageBytes(const cv::Mat& image) {
+        return image.total() * image.elemSize();
+    }
+
+    // Header of a cache file, followed by the key bytes and the raw pixel rows
+    struct DiskHeader {
+        char magic[4];
+        uint32_t formatVersion;
+        uint32_t keyLength;
+        int32_t rows;
+        int32_t cols;
+        int32_t type;
+    };
+
+    const char diskMagic[4] = {'N', 'G', 'R', 'C'};
+    const uint32_t diskFormatVersion = 1;
+
+    // FNV-1a; unlike std::hash its value is stable across runs and builds
+    uint64_t hashKey(const std::string& key) {
+        uint64_t h = 0xcbf29ce484222325ULL;
+        for (unsigned char c : key) {
+            h = (h ^ c) * 0x100000001b3ULL;
+        }
+        return h;
+    }
+
+    uint64_t mix(uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return h;
+    }
+}
+
+ResultCache::ResultCache(size_t budgetBytes) : budget(budgetBytes) {}
+
+bool ResultCache::lookup(const std::string& key, cv::Mat& result) {
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto found = index.find(key);
+        if (found != index.end()) {
+            // Move to the front and hand out a copy so callers can never write into the cache
+            entries.splice(entries.begin(), entries, found->second);
+            result = found->second->image.clone();
+            hits++;
+            return true;
+        }
+
+        if (diskDirectory.empty()) {
+            misses++;
+            return false;
+        }
+        path = diskPath(key);
+    }
+
+    // Disk reads happen outside the lock so other nodes keep using the memory cache
+    cv::Mat loaded;
+    bool onDisk = readFromDisk(path, key, loaded);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!onDisk) {
+        misses++;
+        return false;
+    }
+    insertInMemory(key, loaded);
+    result = loaded.clone();
+    hits++;
+    diskHits++;
+    return true;
+}
+
+void ResultCache::insert(const std::string& key, const cv::Mat& result) {
+    if (result.empty()) {
+        return;
+    }
+
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        insertInMemory(key, result.clone());
+        if (!diskDirectory.empty()) {
+            path = diskPath(key);
+        }
+    }
+
+    // A missing, corrupt or foreign file is replaced; a valid one is left alone
+    if (!path.empty() && !hasDiskEntry(path, key) && writeToDisk(path, key, result)) {
+        std::lock_guard<std::mutex> lock(mutex);
+        diskWrites++;
+    }
+}
+
+void ResultCache::insertInMemory(const std::string& key, const cv::Mat& result) {
+    size_t bytes = imageBytes(result);
+    if (bytes > budget) {
+        return;
+    }
+
+    auto found = index.find(key);
+    if (found != index.end()) {
+        usedBytes -= found->second->bytes;
+        entries.erase(found->second);
+        index.erase(found);
+    }
+
+    entries.push_front({key, result, bytes});
+    index[key] = entries.begin();
+    usedBytes += bytes;
+
+    evictToBudget();
+}
+
+void ResultCache::evictToBudget() {
+    while (usedBytes > budget && !entries.empty()) {
+        const Entry& oldest = entries.back();
+        usedBytes -= oldest.bytes;
+        index.erase(oldest.key);
+        entries.pop_back();
+        evictions++;
+    }
+}
+
+bool ResultCache::setDiskDirectory(const std::string& directory) {
+    if (!directory.empty()) {
+        std::error_code error;
+        std::filesystem::create_directories(directory, error);
+        if (error) {
+            std::cerr << "Cannot create cache directory " << directory << ": " << error.message() << std::endl;
+            return false;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    diskDirectory = directory;
+    return true;
+}
+
+std::string ResultCache::getDiskDirectory() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return diskDirectory;
+}
+
+std::string ResultCache::diskPath(const std::string& key) const {
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.ngrc", static_cast<unsigned long long>(hashKey(key)));
+    return (std::filesystem::path(diskDirectory) / name).string();
+}
+
+bool ResultCache::openDiskEntry(const std::string& path, const std::string& key, std::ifstream& file,
+                                int& rows, int& cols, int& type) const {
+    std::error_code error;
+    const uintmax_t fileBytes = std::filesystem::file_size(path, error);
+    if (error) {
+        return false;
+    }
+    file.open(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+
+    DiskHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, diskMagic, sizeof(diskMagic)) != 0 ||
+        header.formatVersion != diskFormatVersion || header.keyLength != key.size()) {
+        return false;
+    }
+
+    // The full key is stored so a hash collision in the file name reads as a miss
+    std::string storedKey(header.keyLength, '\0');
+    if (!file.read(&storedKey[0], storedKey.size()) || storedKey != key) {
+        return false;
+    }
+
+    // Never trust the header of a corrupt or foreign file: an unknown type or a size
+    // that disagrees with the file length would make cv::Mat throw or over-allocate
+    if ((header.type & ~CV_MAT_TYPE_MASK) != 0 || CV_MAT_DEPTH(header.type) > CV_64F || header.rows <= 0 ||
+        header.cols <= 0) {
+        return false;
+    }
+    const uintmax_t pixelBytes = fileBytes - sizeof(header) - header.keyLength;  // The key was read, so no underflow
+    const uintmax_t rowBytes = static_cast<uintmax_t>(header.cols) * CV_ELEM_SIZE(header.type);
+    if (pixelBytes % rowBytes != 0 || pixelBytes / rowBytes != static_cast<uintmax_t>(header.rows)) {
+        return false;
+    }
+
+    rows = header.rows;
+    cols = header.cols;
+    type = header.type;
+    return true;
+}
+
+bool ResultCache::hasDiskEntry(const std::string& path, const std::string& key) const {
+    std::ifstream file;
+    int rows, cols, type;
+    return openDiskEntry(path, key, file, rows, cols, type);
+}
+
+bool ResultCache::readFromDisk(const std::string& path, const std::string& key, cv::Mat& result) const {
+    std::ifstream file;
+    int rows, cols, type;
+    if (!openDiskEntry(path, key, file, rows, cols, type)) {
+        return false;
+    }
+
+    cv::Mat image(rows, cols, type);
+    const std::streamsize rowBytes = static_cast<std::streamsize>(image.cols * image.elemSize());
+    for (int y = 0; y < image.rows; ++y) {
+        if (!file.read(reinterpret_cast<char*>(image.ptr<uchar>(y)), rowBytes)) {
+            return false;
+        }
+    }
+
+    result = image;
+    return true;
+}
+
+bool ResultCache::writeToDisk(const std::string& path, const std::string& key, const cv::Mat& result) const {
+    DiskHeader header;
+    std::memcpy(header.magic, diskMagic, sizeof(diskMagic));
+    header.formatVersion = diskFormatVersion;
+    header.keyLength = static_cast<uint32_t>(key.size());
+    header.rows = result.rows;
+    header.cols = result.cols;
+    header.type = result.type();
+
+    // Write to a temporary name and rename, so a crash never leaves a truncated entry behind.
+    // The random suffix keeps processes sharing the directory off each other's files.
+    static thread_local std::mt19937_64 suffix(std::random_device{}());
+    std::ostringstream temporaryName;
+    temporaryName << path << '.' << std::hex << suffix() << ".tmp";
+    std::string temporaryPath = temporaryName.str();
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            return false;
+        }
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(key.data(), key.size());
+        const std::streamsize rowBytes = static_cast<std::streamsize>(result.cols * result.elemSize());
+        for (int y = 0; y < result.rows; ++y) {
+            file.write(reinterpret_cast<const char*>(result.ptr<uchar>(y)), rowBytes);
+        }
+        if (!file) {
+            std::cerr << "Failed to write cache file " << temporaryPath << std::endl;
+            file.close();
+            std::remove(temporaryPath.c_str());
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error) {
+        std::filesystem::remove(temporaryPath, error);
+        return false;
+    }
+    return true;
+}
+
+void ResultCache::setBudget(size_t budgetBytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    budget = budgetBytes;
+    evictToBudget();
+}
+
+size_t ResultCache::getBudget() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return budget;
+}
+
+void ResultCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+    index.clear();
+    usedBytes = 0;
+}
+
+ResultCache::Stats ResultCache::getStats() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    Stats stats;
+    stats.hits = hits;
+    stats.misses = misses;
+    stats.evictions = evictions;
+    stats.diskHits = diskHits;
+    stats.diskWrites = diskWrites;
+    stats.entries = entries.size();
+    stats.bytes = usedBytes;
+    return stats;
+}
+
+uint64_t ResultCache::hashImage(const cv::Mat& image) {
+    uint64_t h = mix(static_cast<uint64_t>(image.rows) << 32 ^ static_cast<uint64_t>(image.cols));
+    h = mix(h ^ static_cast<uint64_t>(image.type()));
+    if (image.empty()) {
+        return h;
+    }
+
+    // Four independent lanes keep the multiplies pipelined; rows are hashed
+    // one at a time so views with padding hash the same as their clones
+    const size_t rowBytes = image.cols * image.elemSize();
+    uint64_t lanes[4] = {h, h ^ 0x9e3779b97f4a7c15ULL, h ^ 0xbf58476d1ce4e5b9ULL, h ^ 0x94d049bb133111ebULL};
+    for (int y = 0; y < image.rows; ++y) {
+        const uchar* row = image.ptr<uchar>(y);
+        size_t offset = 0;
+        for (; offset + 32 <= rowBytes; offset += 32) {
+            for (int lane = 0; lane < 4; ++lane) {
+                uint64_t word;
+                std::memcpy(&word, row + offset + lane * 8, sizeof(word));
+                lanes[lane] = (lanes[lane] ^ word) * 0x100000001b3ULL;
+                lanes[lane] ^= lanes[lane] >> 29;
+            }
+        }
+        for (; offset < rowBytes; ++offset) {
+            lanes[0] = (lanes[0] ^ row[offset]) * 0x100000001b3ULL;
+        }
+    }
+
+    return mix(lanes[0] ^ mix(lanes[1]) ^ mix(mix(lanes[2])) ^ mix(mix(mix(lanes[3]))));
+}
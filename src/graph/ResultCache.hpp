@@ -0,0 +1,86 @@
+#pragma once
+#include <opencv2/opencv.hpp>
+#include <cstdint>
+#include <fstream>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Thread-safe LRU cache of node results, bounded by a memory budget.
+// Keys are built by NodeGraph from the node type, the node's serialized
+// parameters and content hashes of its inputs.
+//
+// Optionally every entry is also written to a directory as a raw,
+// uncompressed image file, so results survive a restart: a memory miss
+// falls back to the directory before reporting a miss. Files are never
+// evicted; delete the directory to reclaim the space.
+class ResultCache {
+public:
+    struct Stats {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t evictions = 0;
+        size_t diskHits = 0;    // Hits served from the cache directory (also counted in hits)
+        size_t diskWrites = 0;
+        size_t entries = 0;
+        size_t bytes = 0;  // Memory currently held by cached images
+    };
+
+    explicit ResultCache(size_t budgetBytes);
+
+    // Copies the cached image for `key` into `result`; returns false on a miss
+    bool lookup(const std::string& key, cv::Mat& result);
+
+    // Stores a private copy of `result`, evicting least recently used entries to stay within budget
+    void insert(const std::string& key, const cv::Mat& result);
+
+    // Enables persistence in `directory` (created if needed); an empty path disables it
+    bool setDiskDirectory(const std::string& directory);
+    std::string getDiskDirectory() const;
+
+    void setBudget(size_t budgetBytes);
+    size_t getBudget() const;
+
+    void clear();
+    Stats getStats() const;
+
+    // 64-bit content hash of an image, covering its size, type and pixel data
+    static uint64_t hashImage(const cv::Mat& image);
+
+private:
+    struct Entry {
+        std::string key;
+        cv::Mat image;
+        size_t bytes;
+    };
+
+    void evictToBudget();
+
+    // Inserts an image the cache exclusively owns into the in-memory LRU; the mutex must be held
+    void insertInMemory(const std::string& key, const cv::Mat& result);
+
+    std::string diskPath(const std::string& key) const;
+    // Opens a cache file and validates its header, key and length; on success the stream
+    // is positioned at the first pixel row
+    bool openDiskEntry(const std::string& path, const std::string& key, std::ifstream& file, int& rows, int& cols,
+                       int& type) const;
+    bool hasDiskEntry(const std::string& path, const std::string& key) const;
+    bool readFromDisk(const std::string& path, const std::string& key, cv::Mat& result) const;
+    bool writeToDisk(const std::string& path, const std::string& key, const cv::Mat& result) const;
+
+    std::list<Entry> entries;  // Most recently used at the front
+    std::unordered_map<std::string, std::list<Entry>::iterator> index;
+
+    size_t budget;
+    size_t usedBytes = 0;
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+    size_t diskHits = 0;
+    size_t diskWrites = 0;
+
+    std::string diskDirectory;
+
+    mutable std::mutex mutex;
+};
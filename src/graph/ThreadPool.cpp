@@ -0,0 +1,106 @@
+#include "ThreadPool.hpp"
+
+namespace {
+    // Identifies the pool and deque owned by the current worker thread, if any
+    thread_local const ThreadPool* currentPool = nullptr;
+    thread_local size_t currentWorker = 0;
+}
+
+ThreadPool::ThreadPool(size_t workerCount) {
+    if (workerCount == 0) {
+        workerCount = 1;
+    }
+
+    for (size_t i = 0; i < workerCount; ++i) {
+        queues.push_back(std::make_unique<WorkQueue>());
+    }
+    for (size_t i = 0; i < workerCount; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    size_t target;
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        ++pendingTasks;
+        ++queuedTasks;
+        // Workers keep their follow-up tasks local; everyone else round-robins
+        target = (currentPool == this) ? currentWorker : nextQueue++ % queues.size();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queues[target]->mutex);
+        queues[target]->tasks.push_back(std::move(task));
+    }
+    workAvailable.notify_one();
+}
+
+void ThreadPool::waitIdle() {
+    std::unique_lock<std::mutex> lock(stateMutex);
+    allIdle.wait(lock, [this] { return pendingTasks == 0; });
+}
+
+bool ThreadPool::popLocal(size_t index, std::function<void()>& task) {
+    std::lock_guard<std::mutex> lock(queues[index]->mutex);
+    if (queues[index]->tasks.empty()) {
+        return false;
+    }
+    task = std::move(queues[index]->tasks.back());
+    queues[index]->tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::steal(size_t thief, std::function<void()>& task) {
+    for (size_t offset = 1; offset < queues.size(); ++offset) {
+        WorkQueue& victim = *queues[(thief + offset) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(size_t index) {
+    currentPool = this;
+    currentWorker = index;
+
+    while (true) {
+        std::function<void()> task;
+        if (popLocal(index, task) || steal(index, task)) {
+            {
+                std::lock_guard<std::mutex> lock(stateMutex);
+                --queuedTasks;
+            }
+
+            task();
+
+            std::lock_guard<std::mutex> lock(stateMutex);
+            if (--pendingTasks == 0) {
+                allIdle.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(stateMutex);
+        workAvailable.wait(lock, [this] { return stopping || queuedTasks > 0; });
+        if (stopping && queuedTasks == 0) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size work-stealing thread pool.
+// Every worker owns a deque: it pushes and pops its own tasks at the back
+// (LIFO, cache friendly) and steals from the front of other workers' deques
+// when it runs dry. Tasks submitted from outside the pool are spread
+// round-robin over the worker deques.
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t workerCount);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Queues a task; tasks must not throw
+    void submit(std::function<void()> task);
+
+    // Blocks until every submitted task (including tasks submitted by tasks) has finished
+    void waitIdle();
+
+    size_t getWorkerCount() const { return workers.size(); }
+
+private:
+    struct WorkQueue {
+        std::deque<std::function<void()>> tasks;
+        std::mutex mutex;
+    };
+
+    void workerLoop(size_t index);
+    bool popLocal(size_t index, std::function<void()>& task);
+    bool steal(size_t thief, std::function<void()>& task);
+
+    std::vector<std::unique_ptr<WorkQueue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex stateMutex;
+    std::condition_variable workAvailable;
+    std::condition_variable allIdle;
+    size_t queuedTasks = 0;   // tasks sitting in a deque
+    size_t pendingTasks = 0;  // tasks submitted but not yet finished
+    size_t nextQueue = 0;     // round-robin cursor for external submissions
+    bool stopping = false;
+};
@@ -97,6 +97,10 @@ void splitChannels(std::shared_ptr<ColorChannelSplitterNode> &splitterNode, cv::
         splitterNode->setInput(currentImage);
         splitterNode->process();
 
+        // Write the channels to disk and show them
+        splitterNode->saveChannels();
+        splitterNode->showChannels();
+
         // Notify the user that the channels were split successfully
         std::cout << "Color channels split successfully!" << std::endl;
 
@@ -307,7 +311,7 @@ void applyThreshold(std::shared_ptr<ThresholdNode> &thresholdNode, cv::Mat &curr
     thresholdNode->setInput(currentImage);
 
     // Ask the user for the type of threshold they want to apply
-    std::cout << "Which type of Threshold do you want? (B/A/O)" << std::endl;
+    std::cout << "Which type of Threshold do you want? (B/A/O/S/N)" << std::endl;
     std::string thresholdtype;
     std::cin >> thresholdtype;
 
@@ -324,6 +328,14 @@ void applyThreshold(std::shared_ptr<ThresholdNode> &thresholdNode, cv::Mat &curr
     {
         thresholdNode->setThresholdType(ThresholdNode::OTSU);
     }
+    else if (thresholdtype == "S")
+    {
+        thresholdNode->setThresholdType(ThresholdNode::SAUVOLA);
+    }
+    else if (thresholdtype == "N")
+    {
+        thresholdNode->setThresholdType(ThresholdNode::NIBLACK);
+    }
 
     // Apply the thresholding operation
     thresholdNode->process();
@@ -369,7 +381,7 @@ void applyEdgeDetection(std::shared_ptr<EdgeDetectionNode> &edgeNode, cv::Mat &c
     edgeNode->setInput(currentImage);
 
     // Ask the user for the type of edge detection algorithm to use
-    std::cout << "Give type of Edge Detection Algorithm. (Sobel/Canny)" << std::endl;
+    std::cout << "Give type of Edge Detection Algorithm. (Sobel/Canny/Magnitude)" << std::endl;
     std::string Algotype;
     std::cin >> Algotype;
 
@@ -395,6 +407,11 @@ void applyEdgeDetection(std::shared_ptr<EdgeDetectionNode> &edgeNode, cv::Mat &c
         std::cin >> threshold2;
         edgeNode->setCannyThresholds(threshold1, threshold2);
     }
+    else if (Algotype == "Magnitude" || Algotype == "magnitude")
+    {
+        // Use the gradient magnitude of the 3x3 Sobel operator
+        edgeNode->setEdgeDetectionType(EdgeDetectionNode::SOBEL_MAGNITUDE);
+    }
     else
     {
         // Default to Sobel if the input is invalid
@@ -685,10 +702,11 @@ void convolutionfilter(std::shared_ptr<ConvolutionFilterNode> &convoNode, cv::Ma
     case 4:
     {
         int kernelSize;
-        std::cout << "Enter kernel size (3 or 5): "; // Ask for custom kernel size
-        std::cin >> kernelSize;                      // Get the kernel size from user
-        if (kernelSize == 3 || kernelSize == 5)      // Check if the kernel size is valid (3x3 or 5x5)
+        std::cout << "Enter kernel size (odd, e.g. 3, 5 or 31): "; // Ask for custom kernel size
+        std::cin >> kernelSize;                                    // Get the kernel size from user
+        if (kernelSize > 0 && kernelSize % 2 == 1)                 // Check if the kernel size is valid (odd)
         {
+            convoNode->setKernelSize(kernelSize);                     // Resize the kernel before filling it
             std::vector<float> customKernel(kernelSize * kernelSize); // Create a vector to store custom kernel values
             std::cout << "Enter the values for the " << kernelSize << "x" << kernelSize << " kernel:\n";
 
@@ -698,6 +716,21 @@ void convolutionfilter(std::shared_ptr<ConvolutionFilterNode> &convoNode, cv::Ma
                 std::cin >> customKernel[i]; // Get the individual kernel values from the user
             }
             convoNode->setCustomKernel(customKernel); // Set the custom kernel for the filter
+
+            // The FFT path for large kernels stays off until it is calibrated for this machine
+            static int fftThreshold = -1; // -1: not asked yet this session
+            if (fftThreshold < 0)
+            {
+                char answer;
+                std::cout << "Calibrate the FFT path for large kernels on this machine? (y/n): ";
+                std::cin >> answer;
+                fftThreshold = answer == 'y' || answer == 'Y' ? ConvolutionFilterNode::calibrateFftThreshold() : 0;
+                if (fftThreshold > 0)
+                    std::cout << "Kernels of size " << fftThreshold << " and up will use the FFT path.\n";
+                else
+                    std::cout << "The FFT path stays off; large kernels use filter2D.\n";
+            }
+            convoNode->setFftThreshold(fftThreshold);
         }
         else
         {
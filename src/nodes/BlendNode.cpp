@@ -1,7 +1,314 @@
 #include "BlendNode.hpp"
 #include <opencv2/opencv.hpp>
+#include <opencv2/core/hal/intrin.hpp>
 #include <imgui.h>
 #include <iostream>
+#include <sstream>
+#include <cstdint>
+#include <cmath>
+
+namespace
+{
+    // Integer traits of the fixed-point kernels. `one` is the sample value of 1.0, and
+    // divideByOne(x) is round(x / one); both identities are exact for 0 <= x <= one * one,
+    // so every product below stays in 32 bits.
+    template <typename T>
+    struct FixedPoint;
+
+    template <>
+    struct FixedPoint<uchar>
+    {
+        static constexpr uint32_t one = 255;
+        static uint32_t divideByOne(uint32_t x)
+        {
+            x += 128;
+            return (x + (x >> 8)) >> 8;
+        }
+    };
+
+    template <>
+    struct FixedPoint<ushort>
+    {
+        static constexpr uint32_t one = 65535;
+        static uint32_t divideByOne(uint32_t x)
+        {
+            x += 32768;
+            return (x + (x >> 16)) >> 16;
+        }
+    };
+
+#if CV_SIMD
+    // Vector counterparts of FixedPoint. Each load of T samples is widened into two vectors
+    // of Wide lanes, which hold one * one exactly: uint16 for 8-bit samples and uint32 for
+    // 16-bit ones. Products wrap only in lanes whose result is later discarded by a select.
+    template <typename T>
+    struct FixedPointVector;
+
+    template <>
+    struct FixedPointVector<uchar>
+    {
+        using Wide = cv::v_uint16;
+        static constexpr int lanes = CV_SIMD_WIDTH;
+
+        static Wide setall(uint32_t value) { return cv::vx_setall_u16(static_cast<ushort>(value)); }
+        static Wide multiply(const Wide &a, const Wide &b) { return cv::v_mul_wrap(a, b); }
+        static Wide divideByOne(const Wide &x)
+        {
+            Wide rounded = x + setall(128);
+            return cv::v_shr<8>(rounded + cv::v_shr<8>(rounded));
+        }
+        static void load(const uchar *source, Wide &low, Wide &high) { cv::v_expand(cv::vx_load(source), low, high); }
+        static void store(uchar *destination, const Wide &low, const Wide &high) { cv::v_store(destination, cv::v_pack(low, high)); }
+    };
+
+    template <>
+    struct FixedPointVector<ushort>
+    {
+        using Wide = cv::v_uint32;
+        static constexpr int lanes = CV_SIMD_WIDTH / 2;
+
+        static Wide setall(uint32_t value) { return cv::vx_setall_u32(value); }
+        static Wide multiply(const Wide &a, const Wide &b) { return a * b; }
+        static Wide divideByOne(const Wide &x)
+        {
+            Wide rounded = x + setall(32768);
+            return cv::v_shr<16>(rounded + cv::v_shr<16>(rounded));
+        }
+        static void load(const ushort *source, Wide &low, Wide &high) { cv::v_expand(cv::vx_load(source), low, high); }
+        static void store(ushort *destination, const Wide &low, const Wide &high) { cv::v_store(destination, cv::v_pack(low, high)); }
+    };
+
+    // The vector form of one blendRowFixed sample: same identities, same rounding, so the
+    // vector lanes and the scalar tail produce identical results.
+    template <typename T, BlendNode::BlendMode mode>
+    typename FixedPointVector<T>::Wide blendVectorFixed(const typename FixedPointVector<T>::Wide &x,
+                                                        const typename FixedPointVector<T>::Wide &y,
+                                                        const typename FixedPointVector<T>::Wide &opacity,
+                                                        const typename FixedPointVector<T>::Wide &keep)
+    {
+        using V = FixedPointVector<T>;
+        const typename V::Wide one = V::setall(FixedPoint<T>::one);
+        typename V::Wide blended;
+
+        if constexpr (mode == BlendNode::NORMAL)
+        {
+            blended = y;
+        }
+        else if constexpr (mode == BlendNode::MULTIPLY)
+        {
+            blended = V::divideByOne(V::multiply(x, y));
+        }
+        else if constexpr (mode == BlendNode::SCREEN)
+        {
+            blended = one - V::divideByOne(V::multiply(one - x, one - y));
+        }
+        else if constexpr (mode == BlendNode::OVERLAY)
+        {
+            typename V::Wide dark = V::divideByOne(V::multiply(x + x, y));
+            typename V::Wide light = one - V::divideByOne(V::multiply((one - x) + (one - x), one - y));
+            blended = cv::v_select(x < V::setall((FixedPoint<T>::one + 1) / 2), dark, light);
+        }
+        else
+        {
+            blended = cv::v_absdiff(x, y);
+        }
+
+        return V::divideByOne(V::multiply(blended, opacity) + V::multiply(x, keep));
+    }
+#endif
+
+    // One pass per row with the mode as a template argument. Whole vectors go through
+    // universal intrinsics; the scalar loop handles the tail and builds without CV_SIMD.
+    template <typename T, BlendNode::BlendMode mode>
+    void blendRowFixed(const T *a, const T *b, T *dst, int length, uint32_t opacity)
+    {
+        using FP = FixedPoint<T>;
+        const uint32_t one = FP::one;
+        const uint32_t keep = one - opacity;
+        int i = 0;
+
+#if CV_SIMD
+        using V = FixedPointVector<T>;
+        const typename V::Wide vopacity = V::setall(opacity);
+        const typename V::Wide vkeep = V::setall(keep);
+        for (; i <= length - V::lanes; i += V::lanes)
+        {
+            typename V::Wide x0, x1, y0, y1;
+            V::load(a + i, x0, x1);
+            V::load(b + i, y0, y1);
+            V::store(dst + i,
+                     blendVectorFixed<T, mode>(x0, y0, vopacity, vkeep),
+                     blendVectorFixed<T, mode>(x1, y1, vopacity, vkeep));
+        }
+        cv::vx_cleanup();
+#endif
+
+        for (; i < length; i++)
+        {
+            uint32_t x = a[i];
+            uint32_t y = b[i];
+            uint32_t blended;
+
+            if constexpr (mode == BlendNode::NORMAL)
+            {
+                blended = y;
+            }
+            else if constexpr (mode == BlendNode::MULTIPLY)
+            {
+                blended = FP::divideByOne(x * y);
+            }
+            else if constexpr (mode == BlendNode::SCREEN)
+            {
+                blended = one - FP::divideByOne((one - x) * (one - y));
+            }
+            else if constexpr (mode == BlendNode::OVERLAY)
+            {
+                // Each side only stays within one * one for its own half of a; the other is discarded
+                uint32_t dark = FP::divideByOne(2 * x * y);
+                uint32_t light = one - FP::divideByOne(2 * (one - x) * (one - y));
+                blended = x < (one + 1) / 2 ? dark : light;
+            }
+            else
+            {
+                blended = x > y ? x - y : y - x;
+            }
+
+            dst[i] = static_cast<T>(FP::divideByOne(blended * opacity + x * keep));
+        }
+    }
+
+#if CV_SIMD
+    // The vector form of one blendRowFloat sample. OVERLAY evaluates both sides and picks one
+    // per lane with v_select, so no lane branches.
+    template <BlendNode::BlendMode mode>
+    cv::v_float32 blendVectorFloat(const cv::v_float32 &x, const cv::v_float32 &y,
+                                   const cv::v_float32 &opacity, const cv::v_float32 &keep)
+    {
+        const cv::v_float32 one = cv::vx_setall_f32(1.0f);
+        cv::v_float32 blended;
+
+        if constexpr (mode == BlendNode::NORMAL)
+        {
+            blended = y;
+        }
+        else if constexpr (mode == BlendNode::MULTIPLY)
+        {
+            blended = x * y;
+        }
+        else if constexpr (mode == BlendNode::SCREEN)
+        {
+            blended = one - (one - x) * (one - y);
+        }
+        else if constexpr (mode == BlendNode::OVERLAY)
+        {
+            const cv::v_float32 two = cv::vx_setall_f32(2.0f);
+            cv::v_float32 dark = two * x * y;
+            cv::v_float32 light = one - two * (one - x) * (one - y);
+            blended = cv::v_select(x < cv::vx_setall_f32(0.5f), dark, light);
+        }
+        else
+        {
+            blended = cv::v_absdiff(x, y);
+        }
+
+        return opacity * blended + keep * x;
+    }
+#endif
+
+    template <BlendNode::BlendMode mode>
+    void blendRowFloat(const float *a, const float *b, float *dst, int length, float opacity)
+    {
+        const float keep = 1.0f - opacity;
+        int i = 0;
+
+#if CV_SIMD
+        const int lanes = CV_SIMD_WIDTH / 4;
+        const cv::v_float32 vopacity = cv::vx_setall_f32(opacity);
+        const cv::v_float32 vkeep = cv::vx_setall_f32(keep);
+        for (; i <= length - lanes; i += lanes)
+            cv::v_store(dst + i, blendVectorFloat<mode>(cv::vx_load(a + i), cv::vx_load(b + i), vopacity, vkeep));
+        cv::vx_cleanup();
+#endif
+
+        for (; i < length; i++)
+        {
+            float x = a[i];
+            float y = b[i];
+            float blended;
+
+            if constexpr (mode == BlendNode::NORMAL)
+            {
+                blended = y;
+            }
+            else if constexpr (mode == BlendNode::MULTIPLY)
+            {
+                blended = x * y;
+            }
+            else if constexpr (mode == BlendNode::SCREEN)
+            {
+                blended = 1.0f - (1.0f - x) * (1.0f - y);
+            }
+            else if constexpr (mode == BlendNode::OVERLAY)
+            {
+                float dark = 2.0f * x * y;
+                float light = 1.0f - 2.0f * (1.0f - x) * (1.0f - y);
+                blended = x < 0.5f ? dark : light;
+            }
+            else
+            {
+                blended = std::abs(x - y);
+            }
+
+            dst[i] = opacity * blended + keep * x;
+        }
+    }
+
+    template <typename T>
+    void blendRowDispatch(const T *a, const T *b, T *dst, int length, BlendNode::BlendMode mode, int opacity)
+    {
+        switch (mode)
+        {
+        case BlendNode::NORMAL:
+            blendRowFixed<T, BlendNode::NORMAL>(a, b, dst, length, opacity);
+            break;
+        case BlendNode::MULTIPLY:
+            blendRowFixed<T, BlendNode::MULTIPLY>(a, b, dst, length, opacity);
+            break;
+        case BlendNode::SCREEN:
+            blendRowFixed<T, BlendNode::SCREEN>(a, b, dst, length, opacity);
+            break;
+        case BlendNode::OVERLAY:
+            blendRowFixed<T, BlendNode::OVERLAY>(a, b, dst, length, opacity);
+            break;
+        case BlendNode::DIFFERENCE:
+            blendRowFixed<T, BlendNode::DIFFERENCE>(a, b, dst, length, opacity);
+            break;
+        }
+    }
+
+    // Converts an image to `channels` channels (1, 3 or 4); false for layouts with no conversion.
+    bool matchChannels(const cv::Mat &image, int channels, cv::Mat &converted)
+    {
+        const int codes[5][5] = {
+            {-1, -1, -1, -1, -1},
+            {-1, -1, -1, cv::COLOR_GRAY2BGR, cv::COLOR_GRAY2BGRA},
+            {-1, -1, -1, -1, -1},
+            {-1, cv::COLOR_BGR2GRAY, -1, -1, cv::COLOR_BGR2BGRA},
+            {-1, cv::COLOR_BGRA2GRAY, -1, cv::COLOR_BGRA2BGR, -1}};
+
+        if (image.channels() == channels)
+        {
+            converted = image;
+            return true;
+        }
+        if (image.channels() > 4 || channels > 4 || codes[image.channels()][channels] < 0)
+        {
+            return false;
+        }
+        cv::cvtColor(image, converted, codes[image.channels()][channels]);
+        return true;
+    }
+}
 
 // Constructor for BlendNode, initializing the node with a name and generating a unique ID.
 BlendNode::BlendNode(const std::string &name)
@@ -14,26 +321,37 @@ BlendNode::BlendNode(const std::string &name)
 void BlendNode::setInputA(const cv::Mat &image)
 {
     inputA = image.clone();
+    invalidate(); // A new input must be blended on the next evaluation
 }
 
 // Sets the second input image (inputB) by cloning the provided image.
 void BlendNode::setInputB(const cv::Mat &image)
 {
     inputB = image.clone();
+    invalidate();
+}
+
+// Routes a graph connection to inputA (port 0) or inputB (port 1).
+void BlendNode::setInputAt(int port, const cv::Mat &image)
+{
+    if (port == 1)
+        setInputB(image);
+    else
+        setInputA(image);
 }
 
-// Sets the blending mode and triggers the process to apply the blending operation.
+// Sets the blending mode and marks the node for recomputation.
 void BlendNode::setBlendMode(BlendMode mode)
 {
     blendMode = mode;
-    process(); // Recalculate the output based on the new blend mode
+    markDirty(); // Output must be recalculated with the new blend mode
 }
 
-// Sets the opacity for the blend, clamping the value between 0.0 and 1.0, and triggers reprocessing.
+// Sets the opacity for the blend, clamping the value between 0.0 and 1.0, and marks the node for recomputation.
 void BlendNode::setOpacity(float value)
 {
     opacity = std::clamp(value, 0.0f, 1.0f); // Ensure opacity is within the range [0.0, 1.0]
-    process();                               // Recalculate the blend with the updated opacity
+    markDirty();                             // Blend must be recalculated with the updated opacity
 }
 
 // Returns the final blended output image.
@@ -42,6 +360,64 @@ cv::Mat BlendNode::getOutput() const
     return outputImage;
 }
 
+// Restores a previously computed blended image.
+void BlendNode::setOutput(const cv::Mat &output)
+{
+    outputImage = output;
+}
+
+// Builds the cache key from the blend mode and opacity.
+std::string BlendNode::getCacheKey() const
+{
+    std::ostringstream key;
+    key.precision(9);
+    key << blendMode << '|' << opacity;
+    return key.str();
+}
+
+bool BlendNode::getInputImages(std::vector<cv::Mat> &images) const
+{
+    images = {inputA, inputB};
+    return true;
+}
+
+void BlendNode::blendRow8U(const uchar *a, const uchar *b, uchar *dst, int length, BlendMode mode, int opacity)
+{
+    blendRowDispatch<uchar>(a, b, dst, length, mode, opacity);
+}
+
+void BlendNode::blendRow16U(const ushort *a, const ushort *b, ushort *dst, int length, BlendMode mode, int opacity)
+{
+    blendRowDispatch<ushort>(a, b, dst, length, mode, opacity);
+}
+
+void BlendNode::blendRow32F(const float *a, const float *b, float *dst, int length, BlendMode mode, float opacity)
+{
+    switch (mode)
+    {
+    case NORMAL:
+        blendRowFloat<NORMAL>(a, b, dst, length, opacity);
+        break;
+    case MULTIPLY:
+        blendRowFloat<MULTIPLY>(a, b, dst, length, opacity);
+        break;
+    case SCREEN:
+        blendRowFloat<SCREEN>(a, b, dst, length, opacity);
+        break;
+    case OVERLAY:
+        blendRowFloat<OVERLAY>(a, b, dst, length, opacity);
+        break;
+    case DIFFERENCE:
+        blendRowFloat<DIFFERENCE>(a, b, dst, length, opacity);
+        break;
+    }
+}
+
+double BlendNode::unitScale(int depth)
+{
+    return depth == CV_16U ? 1.0 / 65535.0 : 1.0 / 255.0;
+}
+
 // Processes the blending operation based on the selected mode and opacity.
 void BlendNode::process()
 {
@@ -49,58 +425,81 @@ void BlendNode::process()
     if (inputA.empty() || inputB.empty())
     {
         std::cerr << "One or both input images are empty in BlendNode: " << name << std::endl;
+        outputImage.release();
         return;
     }
 
     // Resize the second image (inputB) to match the size of inputA
-    cv::Mat resizedB;
-    cv::resize(inputB, resizedB, inputA.size()); // Resize to ensure the images have the same size
+    cv::Mat resizedB = inputB;
+    if (inputB.size() != inputA.size())
+    {
+        cv::resize(inputB, resizedB, inputA.size()); // Resize to ensure the images have the same size
+    }
 
-    // Convert the input images to floating-point values for precise blending operations
-    cv::Mat blendA, blendB;
-    inputA.convertTo(blendA, CV_32F, 1.0 / 255.0);   // Normalize inputA to [0, 1]
-    resizedB.convertTo(blendB, CV_32F, 1.0 / 255.0); // Normalize inputB to [0, 1]
+    // Integer images of matching type are blended in a single fixed-point pass
+    if (inputA.type() == resizedB.type() && (inputA.depth() == CV_8U || inputA.depth() == CV_16U))
+    {
+        blendFixedPoint(resizedB);
+    }
+    else
+    {
+        blendFloat(resizedB);
+    }
+}
 
-    cv::Mat result; // The resulting blended image
+// Blends each row once with the fixed-point kernels, splitting rows across threads.
+void BlendNode::blendFixedPoint(const cv::Mat &imageB)
+{
+    outputImage.create(inputA.size(), inputA.type());
+    const int rowLength = inputA.cols * inputA.channels();
+    const bool sixteenBit = inputA.depth() == CV_16U;
+    const int fixedOpacity = cvRound(opacity * (sixteenBit ? 65535.0f : 255.0f));
 
-    // Apply the selected blend mode
-    switch (blendMode)
-    {
-    case NORMAL:
-        result = blendB; // Normal mode: just return inputB
-        break;
-    case MULTIPLY:
-        cv::multiply(blendA, blendB, result); // Multiply mode: element-wise multiplication
-        break;
-    case SCREEN:
-        result = 1.0 - (1.0 - blendA).mul(1.0 - blendB); // Screen mode: inverse multiplication
-        break;
-    case OVERLAY:
-        result = cv::Mat(blendA.size(), blendA.type());
-        // Overlay mode: mix based on the brightness of blendA
-        for (int y = 0; y < blendA.rows; y++)
+    cv::parallel_for_(cv::Range(0, inputA.rows), [&](const cv::Range &rows)
+                      {
+        for (int y = rows.start; y < rows.end; y++)
         {
-            for (int x = 0; x < blendA.cols; x++)
+            if (sixteenBit)
             {
-                for (int c = 0; c < blendA.channels(); c++)
-                {
-                    float a = blendA.at<cv::Vec3f>(y, x)[c];
-                    float b = blendB.at<cv::Vec3f>(y, x)[c];
-                    result.at<cv::Vec3f>(y, x)[c] = (a < 0.5f) ? (2 * a * b) : (1 - 2 * (1 - a) * (1 - b));
-                }
+                blendRow16U(inputA.ptr<ushort>(y), imageB.ptr<ushort>(y), outputImage.ptr<ushort>(y), rowLength, blendMode, fixedOpacity);
             }
-        }
-        break;
-    case DIFFERENCE:
-        result = cv::abs(blendA - blendB); // Difference mode: absolute difference between the images
-        break;
+            else
+            {
+                blendRow8U(inputA.ptr<uchar>(y), imageB.ptr<uchar>(y), outputImage.ptr<uchar>(y), rowLength, blendMode, fixedOpacity);
+            }
+        } });
+}
+
+// Blends in 32-bit float, used when the inputs are not integer images of the same type.
+void BlendNode::blendFloat(const cv::Mat &imageB)
+{
+    // The row kernel walks both inputs as flat sample rows, so their layouts must agree
+    cv::Mat matchedB;
+    if (!matchChannels(imageB, inputA.channels(), matchedB))
+    {
+        std::cerr << "Cannot blend a " << imageB.channels() << "-channel image onto a " << inputA.channels()
+                  << "-channel image in BlendNode: " << name << std::endl;
+        outputImage.release();
+        return;
     }
 
-    // Blend the result with the specified opacity
-    result = opacity * result + (1.0f - opacity) * blendA;
+    // Normalize each input with the scale of its own depth
+    cv::Mat blendA, blendB;
+    inputA.convertTo(blendA, CV_32F, unitScale(inputA.depth()));
+    matchedB.convertTo(blendB, CV_32F, unitScale(matchedB.depth()));
+
+    // One fused pass per row applies the mode and the opacity mix
+    cv::Mat result(blendA.size(), blendA.type());
+    const int rowLength = blendA.cols * blendA.channels();
+    cv::parallel_for_(cv::Range(0, blendA.rows), [&](const cv::Range &rows)
+                      {
+        for (int y = rows.start; y < rows.end; y++)
+        {
+            blendRow32F(blendA.ptr<float>(y), blendB.ptr<float>(y), result.ptr<float>(y), rowLength, blendMode, opacity);
+        } });
 
     // Convert the result back to an 8-bit image for display
-    result.convertTo(outputImage, CV_8U, 255.0); // Convert to 8-bit image in the range [0, 255]
+    result.convertTo(outputImage, floatOutputDepth, 1.0 / unitScale(floatOutputDepth));
 }
 
 // Renders the user interface for controlling the blend mode and opacity using ImGui.
@@ -111,12 +510,12 @@ void BlendNode::renderUI()
     // Create a combo box for selecting the blend mode
     if (ImGui::Combo("Blend Mode", reinterpret_cast<int *>(&blendMode), blendNames, IM_ARRAYSIZE(blendNames)))
     {
-        process(); // Reprocess the blend if the mode is changed
+        markDirty(); // Reprocess the blend if the mode is changed
     }
 
     // Create a slider for adjusting the opacity
     if (ImGui::SliderFloat("Opacity", &opacity, 0.0f, 1.0f))
     {
-        process(); // Reprocess the blend if the opacity is changed
+        markDirty(); // Reprocess the blend if the opacity is changed
     }
 }
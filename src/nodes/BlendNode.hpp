@@ -25,6 +25,9 @@ public:
     // Sets the second input image (inputB) to be used in the blend.
     void setInputB(const cv::Mat &image);
 
+    // Graph port routing: port 0 is inputA, port 1 is inputB.
+    void setInputAt(int port, const cv::Mat &image) override;
+
     // Sets the blend mode to one of the available modes from the enum.
     void setBlendMode(BlendMode mode);
 
@@ -40,7 +43,37 @@ public:
     // Returns the resulting blended image.
     cv::Mat getOutput() const override;
 
+    // Fused fixed-point kernels: blends `length` samples of a with b and mixes the result
+    // back over a by opacity (0 keeps a, 255 or 65535 applies the full blend) in one pass.
+    // dst may alias a.
+    static void blendRow8U(const uchar *a, const uchar *b, uchar *dst, int length, BlendMode mode, int opacity);
+    static void blendRow16U(const ushort *a, const ushort *b, ushort *dst, int length, BlendMode mode, int opacity);
+
+    // Float counterpart for samples in [0, 1], with opacity in [0, 1].
+    static void blendRow32F(const float *a, const float *b, float *dst, int length, BlendMode mode, float opacity);
+
+    // Float path conventions shared with CompositeNode: unitScale maps a depth's samples to
+    // [0, 1] (1/65535 for 16-bit, 1/255 for every other depth, floats included), and the
+    // result is always written back as floatOutputDepth.
+    static double unitScale(int depth);
+    static constexpr int floatOutputDepth = CV_8U;
+
+    // Restores a cached blended image.
+    void setOutput(const cv::Mat &output) override;
+
+    // Serializes blend mode and opacity for the graph's result cache.
+    std::string getCacheKey() const override;
+
+    // Hands out inputA and inputB for the cache key when they were set directly.
+    bool getInputImages(std::vector<cv::Mat> &images) const override;
+
 private:
+    // Blends 8-bit or 16-bit inputs of the same type with the fixed-point row kernels.
+    void blendFixedPoint(const cv::Mat &imageB);
+
+    // Blends any other inputs in 32-bit float; inputB is first converted to inputA's channel count.
+    void blendFloat(const cv::Mat &imageB);
+
     // The first input image (left operand for blending)
     cv::Mat inputA;
 
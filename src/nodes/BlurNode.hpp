@@ -2,22 +2,52 @@
 #include "../graph/Node.hpp"  // Include the base Node class for inheritance
 #include <opencv2/opencv.hpp>  // OpenCV for image processing
 #include <iostream>  // For input-output operations
+#include <map>  // Cache of 1D Gaussian kernels by radius
+#include <vector>  // Box widths for the stacked box approximation
 
 // BlurNode class that inherits from the Node class
 class BlurNode : public Node {
+public:
+    // How the (non-directional) Gaussian blur is computed
+    enum class GaussianMethod {
+        Separable,   // Exact sampled Gaussian, row and column passes: cost grows with the radius
+        StackedBox   // Three running-sum box passes: cost independent of the radius, approximate
+    };
+
 private:
     cv::Mat inputImage;  // Input image to be processed
     cv::Mat outputImage;  // Output image after processing (blurred)
+    PlanarImage planarInput;  // Planar input, used instead of inputImage when set
+    PlanarImage planarOutput;  // Planar result, kept when every consumer takes planar input
     int radius = 3;  // Radius for the blur effect, default is 3
     bool directional = false;  // Flag to determine if directional blur is used
     float angle = 0.0f;  // Angle for directional blur, default is 0 (horizontal)
+    GaussianMethod gaussianMethod = GaussianMethod::Separable;  // Exact Gaussian by default
 
-    // Function to generate a directional kernel based on radius and angle
+    // Function to generate a directional kernel based on radius and angle (used for the preview)
     cv::Mat generateDirectionalKernel(int radius, float angle);
 
-    // Function to generate a Gaussian blur kernel based on the radius
+    // Function to average 2 * radius + 1 sub-pixel samples along the blur direction for every pixel
+    void applyDirectionalBlur(const cv::Mat& input, cv::Mat& output);
+
+    // Function to generate a Gaussian blur kernel based on the radius (2D, used for the preview)
     cv::Mat generateGaussianKernel(int radius);
 
+    // Function to fetch the normalized 1D Gaussian kernel for a radius, building it on first use
+    const cv::Mat& getGaussianKernel1D(int radius);
+
+    // 1D Gaussian kernels (column vectors) already built, keyed by radius
+    std::map<int, cv::Mat> gaussianKernels1D;
+
+    // Function to compute the odd box widths whose repeated convolution best matches a Gaussian of the given sigma
+    static std::vector<int> boxWidthsForSigma(float sigma, int passes);
+
+    // Function to approximate the Gaussian with stacked box filters in constant time per pixel
+    void applyStackedBoxBlur(const cv::Mat& input, cv::Mat& output);
+
+    // Function to blur one image (interleaved or a single plane) with the selected method
+    void blurImage(const cv::Mat& source, cv::Mat& destination);
+
 public:
     // Constructor to initialize the BlurNode with a name
     BlurNode(const std::string& name);
@@ -34,6 +64,20 @@ public:
     // Override method to get the processed (blurred) output image
     cv::Mat getOutput() const override;
 
+    // Restore a cached output image
+    void setOutput(const cv::Mat& output) override;
+
+    // The blur treats every channel independently, so it can stay planar
+    bool supportsPlanar() const override;
+    void setPlanarInputAt(int port, const PlanarImage& input) override;
+    PlanarImage getPlanarOutput() const override;
+
+    // Serialize radius, mode and angle for the graph's result cache
+    std::string getCacheKey() const override;
+
+    // The input image, hashed into the cache key when it was set directly
+    bool getInputImages(std::vector<cv::Mat>& images) const override;
+
     // Method to set a new radius for the blur effect and apply the change
     void setRadius(int newRadius);
 
@@ -42,4 +86,7 @@ public:
 
     // Method to enable or disable directional blur and apply the change
     void setDirectional(bool isDirectional);
+
+    // Method to choose between the exact separable Gaussian and the constant-time box approximation
+    void setGaussianMethod(GaussianMethod method);
 };
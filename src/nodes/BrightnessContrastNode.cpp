@@ -1,5 +1,6 @@
 #include "BrightnessContrastNode.hpp"
 #include <iostream>
+#include <sstream>
 
 // Constructor initializing the name and unique id for the node
 BrightnessContrastNode::BrightnessContrastNode(const std::string& name) {
@@ -18,18 +19,21 @@ BrightnessContrastNode::BrightnessContrastNode(const std::string& name, double a
 // Method to set the input image for processing
 void BrightnessContrastNode::setInput(const cv::Mat& input) {
     inputImage = input;
+    invalidate();  // A new input must be adjusted on the next evaluation
 }
 
 // Method to set new contrast (alpha) and brightness (beta) values
 void BrightnessContrastNode::setParams(double contrast, int brightness) {
     this->alpha = contrast;  // Set new contrast value
     this->beta = brightness; // Set new brightness value
+    markDirty();             // Output must be recomputed with the new values
 }
 
 // Method to reset the parameters to default values: α = 1.0 (no contrast change), β = 0 (no brightness change)
 void BrightnessContrastNode::resetParams() {
     this->alpha = 1.0;  // Default contrast is 1 (no change)
     this->beta = 0;     // Default brightness is 0 (no change)
+    markDirty();
     std::cout << "Reset parameters to default: α = " << alpha << ", β = " << beta << std::endl;
 }
 
@@ -41,11 +45,45 @@ void BrightnessContrastNode::process() {
         return;
     }
     
-    // Apply contrast and brightness using OpenCV's convertTo method
-    inputImage.convertTo(outputImage, -1, alpha, beta);
+    // 8-bit input has only 256 possible values, so the mapping is a single table lookup per sample
+    if (inputImage.depth() == CV_8U) {
+        getLookupTable().apply(inputImage, outputImage);
+    } else {
+        // Apply contrast and brightness using OpenCV's convertTo method
+        inputImage.convertTo(outputImage, -1, alpha, beta);
+    }
     std::cout << "Applied Brightness/Contrast to: " << name << std::endl;
 }
 
+// Method to get the alpha/beta table, rebuilt only when the parameters moved since it was built
+const LookupTable& BrightnessContrastNode::getLookupTable() {
+    if (alpha != lutAlpha || beta != lutBeta) {
+        lut = LookupTable::linear(alpha, beta);
+        lutAlpha = alpha;
+        lutBeta = beta;
+    }
+    return lut;
+}
+
+// Method to report whether the node can be fused with neighbouring point operations
+bool BrightnessContrastNode::isPointOperation(const cv::Mat& input) const {
+    return input.depth() == CV_8U || input.depth() == CV_32F;
+}
+
+// Method to apply the contrast and brightness to a row of float samples
+void BrightnessContrastNode::applyPointRow(float* values, int length) const {
+    const float scale = static_cast<float>(alpha);
+    const float shift = static_cast<float>(beta);
+    for (int i = 0; i < length; i++) {
+        values[i] = values[i] * scale + shift;
+    }
+}
+
+// Method to get the contrast and brightness as an 8-bit table
+LookupTable BrightnessContrastNode::pointLUT() const {
+    return LookupTable::linear(alpha, beta);
+}
+
 // Method to render the user interface for adjusting contrast (alpha) and brightness (beta) values
 void BrightnessContrastNode::renderUI() {
     // Log the current contrast and brightness values to the console
@@ -58,11 +96,12 @@ void BrightnessContrastNode::renderUI() {
     // Render a slider for adjusting the contrast (α)
     if (ImGui::SliderFloat("Contrast (α)", &alphaFloat, 0.0f, 3.0f)) {
         alpha = static_cast<double>(alphaFloat);  // Update alpha with the new value from the slider
+        markDirty();
     }
 
     // Render a slider for adjusting the brightness (β)
     if (ImGui::SliderInt("Brightness (β)", &beta, -100, 100)) {
-        // Nothing needed here since the slider directly updates the beta value
+        markDirty();  // The slider directly updates the beta value, only the output is stale
     }
 
     // Render a button to reset the contrast and brightness parameters to their defaults
@@ -76,3 +115,21 @@ void BrightnessContrastNode::renderUI() {
 cv::Mat BrightnessContrastNode::getOutput() const {
     return outputImage;  // Return the output image
 }
+
+// Method to restore a previously computed output image
+void BrightnessContrastNode::setOutput(const cv::Mat& output) {
+    outputImage = output;
+}
+
+// Method to build the cache key from contrast and brightness
+std::string BrightnessContrastNode::getCacheKey() const {
+    std::ostringstream key;
+    key.precision(17);
+    key << alpha << '|' << beta;
+    return key.str();
+}
+
+bool BrightnessContrastNode::getInputImages(std::vector<cv::Mat>& images) const {
+    images = {inputImage};
+    return true;
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include "../graph/Node.hpp"  // Base class Node is included to inherit from it
+#include "../graph/LookupTable.hpp"  // Table-driven path for 8-bit input
 #include <opencv2/opencv.hpp>  // OpenCV library for image processing
 #include <imgui.h>  // ImGui for rendering user interface
 
@@ -11,6 +12,13 @@ private:
     double alpha = 1.0;   // Contrast factor (default: no contrast change)
     int beta = 0;         // Brightness offset (default: no brightness change)
 
+    LookupTable lut;          // alpha/beta mapping for 8-bit input, rebuilt when they change
+    double lutAlpha = 1.0;    // alpha the table was built for
+    int lutBeta = 0;          // beta the table was built for
+
+    // Returns the table for the current alpha and beta, rebuilding it if they changed
+    const LookupTable& getLookupTable();
+
 public:
     // Constructor: Initializes the node with a name and sets default values for alpha and beta
     BrightnessContrastNode(const std::string& name);
@@ -33,6 +41,20 @@ public:
     // Get the output image after applying brightness and contrast adjustments
     cv::Mat getOutput() const override;
 
+    // Restore a cached output image
+    void setOutput(const cv::Mat& output) override;
+
+    // Serialize alpha and beta for the graph's result cache
+    std::string getCacheKey() const override;
+
+    // The input image, hashed into the cache key when it was set directly
+    bool getInputImages(std::vector<cv::Mat>& images) const override;
+
+    // Brightness/contrast is a point operation on 8-bit and float images
+    bool isPointOperation(const cv::Mat& input) const override;
+    void applyPointRow(float* values, int length) const override;
+    LookupTable pointLUT() const override;
+
     // Reset the contrast and brightness parameters to their default values
     void resetParams();
 };
@@ -13,40 +13,86 @@ ColorChannelSplitterNode::ColorChannelSplitterNode(const std::string& name, bool
 // Sets the input image for processing
 void ColorChannelSplitterNode::setInput(const cv::Mat& input) {
     inputImage = input;
+    invalidate();  // Consumers must pick up the new planes on the next evaluation
+
+    // Planes of the previous input are stale
+    std::lock_guard<std::mutex> lock(planeMutex);
+    for (cv::Mat& plane : channelPlanes) {
+        plane.release();
+    }
 }
 
-// Process the image by splitting it into color channels (Red, Green, Blue, and optionally Alpha)
-// If grayscale output is enabled, the grayscale image will also be generated
+// Nothing is split up front: planes are only extracted when a port is read, so channels
+// nothing consumes are never copied. Files and windows are left to saveChannels() and
+// showChannels().
 void ColorChannelSplitterNode::process() {
+    if (inputImage.empty()) {
+        std::cerr << "No input image for ColorChannelSplitterNode: " << name << std::endl;
+    }
+}
+
+int ColorChannelSplitterNode::getOutputCount() const {
+    return 5;
+}
+
+// Port 0 is the node's regular output, so default connections keep receiving it. Channel
+// ports extract a single channel on first use. Images are stored in BGR(A) order, so the
+// red plane is channel 2 and the blue plane channel 0.
+cv::Mat ColorChannelSplitterNode::getOutputAt(int port) const {
+    if (port == COMBINED) {
+        return getOutput();
+    }
+
+    static const int channelOf[4] = {2, 1, 0, 3};
+    const int plane = port - RED;
+    if (plane < 0 || plane >= 4 || inputImage.channels() <= channelOf[plane] || inputImage.channels() < 3) {
+        return cv::Mat();
+    }
+
+    std::lock_guard<std::mutex> lock(planeMutex);
+    if (channelPlanes[plane].empty()) {
+        cv::extractChannel(inputImage, channelPlanes[plane], channelOf[plane]);
+    }
+    return channelPlanes[plane];
+}
+
+// Merge the individual RGB (or RGBA) channels back into a single image
+cv::Mat ColorChannelSplitterNode::mergeChannels() {
+    if (inputImage.channels() < 3) {
+        std::cerr << "One or more channels are empty, cannot merge." << std::endl;
+        return cv::Mat();  // Return an empty matrix if any channel is empty
+    }
+
+    // The planes are unchanged views of the input, so merging them back is the input itself
+    if (inputImage.channels() == 3) {
+        return inputImage.clone();
+    }
+
+    // Drop the alpha plane for a standard color image
+    cv::Mat mergedImage;
+    cv::cvtColor(inputImage, mergedImage, cv::COLOR_BGRA2BGR);
+    return mergedImage;
+}
+
+// Save each channel as separate images, plus grayscale versions if enabled
+void ColorChannelSplitterNode::saveChannels() const {
     if (inputImage.empty()) {
         std::cerr << "No input image for ColorChannelSplitterNode: " << name << std::endl;
         return;
     }
 
-    cv::Mat grayscale;
+    cv::Mat redChannel = getOutputAt(RED);
+    cv::Mat greenChannel = getOutputAt(GREEN);
+    cv::Mat blueChannel = getOutputAt(BLUE);
+
     if (outputGrayscale) {
         // Convert to grayscale if enabled
+        cv::Mat grayscale;
         cv::cvtColor(inputImage, grayscale, cv::COLOR_BGR2GRAY);
         cv::imwrite("GrayScale.png", grayscale);  // Save the grayscale image
         std::cout << "Image converted to grayscale." << std::endl;
     }
 
-    std::vector<cv::Mat> channels;
-    // Split the input image into its RGB (or RGBA) channels
-    if (inputImage.channels() == 3) {
-        cv::split(inputImage, channels);
-        redChannel = channels[2];
-        greenChannel = channels[1];
-        blueChannel = channels[0];
-    } else if (inputImage.channels() == 4) {
-        cv::split(inputImage, channels);
-        redChannel = channels[2];
-        greenChannel = channels[1];
-        blueChannel = channels[0];
-        alphaChannel = channels[3];
-    }
-
-    // Save each channel as separate images
     if (!redChannel.empty()) {
         cv::imwrite("Red_Channel.png", redChannel);
     }
@@ -58,41 +104,24 @@ void ColorChannelSplitterNode::process() {
     }
 
     // Save grayscale versions of each channel, if outputGrayscale is enabled
-    if (outputGrayscale) {
+    if (outputGrayscale && !redChannel.empty()) {
         cv::imwrite("Red_Grayscale.png", redChannel);
         cv::imwrite("Green_Grayscale.png", greenChannel);
         cv::imwrite("Blue_Grayscale.png", blueChannel);
     }
-
-    // Display each channel in a window for visualization
-    if (!redChannel.empty()) {
-        cv::imshow("Red Channel", redChannel);
-    }
-    if (!greenChannel.empty()) {
-        cv::imshow("Green Channel", greenChannel);
-    }
-    if (!blueChannel.empty()) {
-        cv::imshow("Blue Channel", blueChannel);
-    }
-    if (!alphaChannel.empty()) {
-        cv::imshow("Alpha Channel", alphaChannel);
-    }
-
-    cv::waitKey(0);  // Wait for a key press to close the display windows
 }
 
-// Merge the individual RGB (or RGBA) channels back into a single image
-cv::Mat ColorChannelSplitterNode::mergeChannels() {
-    if (redChannel.empty() || greenChannel.empty() || blueChannel.empty()) {
-        std::cerr << "One or more channels are empty, cannot merge." << std::endl;
-        return cv::Mat();  // Return an empty matrix if any channel is empty
+// Display each channel in a window for visualization
+void ColorChannelSplitterNode::showChannels() const {
+    const char* windowNames[4] = {"Red Channel", "Green Channel", "Blue Channel", "Alpha Channel"};
+    for (int port = RED; port <= ALPHA; port++) {
+        cv::Mat plane = getOutputAt(port);
+        if (!plane.empty()) {
+            cv::imshow(windowNames[port - RED], plane);
+        }
     }
 
-    // Merge channels in RGB order for a standard color image
-    std::vector<cv::Mat> channels = {blueChannel, greenChannel, redChannel};
-    cv::Mat mergedImage;
-    cv::merge(channels, mergedImage);
-    return mergedImage;
+    cv::waitKey(0);  // Wait for a key press to close the display windows
 }
 
 // Render the user interface for the ColorChannelSplitterNode to adjust settings and visualize channels
@@ -101,60 +130,41 @@ void ColorChannelSplitterNode::renderUI() {
 
     // Checkbox to toggle grayscale output
     if (ImGui::Checkbox("Output Grayscale", &outputGrayscale)) {
-        process();
+        markDirty();
     }
 
     // Display the Red, Green, Blue, and Alpha channels if available
-    if (!redChannel.empty()) {
-        ImGui::Text("Red Channel");
-        cv::Mat redChannelDisplay;
-        cv::cvtColor(redChannel, redChannelDisplay, cv::COLOR_GRAY2BGRA);
-        ImTextureID redTexture = reinterpret_cast<ImTextureID>(redChannelDisplay.data);
-        ImGui::Image(redTexture, ImVec2(redChannel.cols, redChannel.rows));
-    }
-
-    if (!greenChannel.empty()) {
-        ImGui::Text("Green Channel");
-        cv::Mat greenChannelDisplay;
-        cv::cvtColor(greenChannel, greenChannelDisplay, cv::COLOR_GRAY2BGRA);
-        ImTextureID greenTexture = reinterpret_cast<ImTextureID>(greenChannelDisplay.data);
-        ImGui::Image(greenTexture, ImVec2(greenChannel.cols, greenChannel.rows));
-    }
-
-    if (!blueChannel.empty()) {
-        ImGui::Text("Blue Channel");
-        cv::Mat blueChannelDisplay;
-        cv::cvtColor(blueChannel, blueChannelDisplay, cv::COLOR_GRAY2BGRA);
-        ImTextureID blueTexture = reinterpret_cast<ImTextureID>(blueChannelDisplay.data);
-        ImGui::Image(blueTexture, ImVec2(blueChannel.cols, blueChannel.rows));
-    }
-
-    if (!alphaChannel.empty()) {
-        ImGui::Text("Alpha Channel");
-        cv::Mat alphaChannelDisplay;
-        cv::cvtColor(alphaChannel, alphaChannelDisplay, cv::COLOR_GRAY2BGRA);
-        ImTextureID alphaTexture = reinterpret_cast<ImTextureID>(alphaChannelDisplay.data);
-        ImGui::Image(alphaTexture, ImVec2(alphaChannel.cols, alphaChannel.rows));
+    const char* labels[4] = {"Red Channel", "Green Channel", "Blue Channel", "Alpha Channel"};
+    for (int port = RED; port <= ALPHA; port++) {
+        cv::Mat plane = getOutputAt(port);
+        if (plane.empty()) {
+            continue;
+        }
+        ImGui::Text("%s", labels[port - RED]);
+        cv::Mat planeDisplay;
+        cv::cvtColor(plane, planeDisplay, cv::COLOR_GRAY2BGRA);
+        ImTextureID texture = reinterpret_cast<ImTextureID>(planeDisplay.data);
+        ImGui::Image(texture, ImVec2(plane.cols, plane.rows));
     }
 }
 
 // Get the output image based on the grayscale flag
 cv::Mat ColorChannelSplitterNode::getOutput() const {
     if (outputGrayscale) {
-        return redChannel;  // If grayscale, return the red channel (or any single channel)
+        return getOutputAt(RED);  // If grayscale, return the red channel (or any single channel)
     } else {
         return inputImage;  // Otherwise, return the original input image
     }
 }
 
-// Enable or disable grayscale output, and reprocess the image accordingly
+// Enable or disable grayscale output, and mark the image for reprocessing
 void ColorChannelSplitterNode::setOutputGrayscale(bool enable) {
     outputGrayscale = enable;
-    process();
+    markDirty();
 }
 
-// Reset parameters, disabling grayscale output and reprocessing the image
+// Reset parameters, disabling grayscale output and marking the image for reprocessing
 void ColorChannelSplitterNode::resetParams() {
     outputGrayscale = false;
-    process();
+    markDirty();
 }
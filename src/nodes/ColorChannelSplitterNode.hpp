@@ -2,6 +2,7 @@
 #include "../graph/Node.hpp"
 #include <opencv2/opencv.hpp>
 #include <vector>
+#include <mutex>
 
 // ColorChannelSplitterNode: A class for splitting the color channels (Red, Green, Blue, and optionally Alpha) of an image
 class ColorChannelSplitterNode : public Node {
@@ -21,22 +22,38 @@ public:
     // Returns the processed image based on grayscale flag (either the input image or the red channel)
     cv::Mat getOutput() const override;
 
+    // Output ports: port 0 is getOutput(), followed by one port per channel
+    enum OutputPort { COMBINED, RED, GREEN, BLUE, ALPHA };
+
+    // Five ports: getOutput(), then Red, Green, Blue and Alpha (empty unless the input has four channels)
+    int getOutputCount() const override;
+
+    // Returns getOutput() on port 0 and the plane on a channel port, extracting it on first use
+    cv::Mat getOutputAt(int port) const override;
+
     // Merges the individual RGB (or RGBA) channels back into a single image
     cv::Mat mergeChannels();
 
+    // Writes every channel (and grayscale versions, if enabled) to PNG files
+    void saveChannels() const;
+
+    // Shows every channel in its own window and waits for a key press
+    void showChannels() const;
+
     // Enables or disables grayscale output
     void setOutputGrayscale(bool enable);
 
     // Resets the parameters to default settings
     void resetParams();
 
-    // Member variables to hold the input image and the individual color channels (Red, Green, Blue, Alpha)
+    // Member variable to hold the input image
     cv::Mat inputImage; 
-    cv::Mat redChannel;
-    cv::Mat greenChannel;
-    cv::Mat blueChannel;
-    cv::Mat alphaChannel;  
 
     // Flag to determine whether grayscale output is enabled
     bool outputGrayscale; 
+
+private:
+    // Planes extracted so far for the current input, indexed by OutputPort - RED
+    mutable cv::Mat channelPlanes[4];
+    mutable std::mutex planeMutex; // Consumers on different threads may request planes at once
 };
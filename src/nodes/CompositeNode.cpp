@@ -0,0 +1,306 @@
+#include "CompositeNode.hpp"
+#include <opencv2/opencv.hpp>
+#include <imgui.h>
+#include <iostream>
+#include <sstream>
+#include <cstring>
+#include <algorithm>
+#include "../graph/ResultCache.hpp"
+
+namespace
+{
+    // Pixels per tile row: one strip of the running composite and of a layer stay in L1
+    // while every layer is applied to it
+    const int tileColumns = 1024;
+}
+
+// Constructor: Initializes the CompositeNode with the given name.
+CompositeNode::CompositeNode(const std::string &name)
+{
+    this->name = name;
+    this->id = "composite_node_" + name; // Generate a unique ID for the node
+}
+
+void CompositeNode::addLayer(const cv::Mat &image, BlendNode::BlendMode mode, float opacity)
+{
+    Layer layer;
+    layer.image = image;
+    layer.mode = mode;
+    layer.opacity = std::max(0.0f, std::min(opacity, 1.0f));
+    layers.push_back(layer);
+    markDirty();
+}
+
+void CompositeNode::removeLayer(int index)
+{
+    if (!isValidLayer(index))
+        return;
+
+    layers.erase(layers.begin() + index);
+    markDirty();
+}
+
+int CompositeNode::getLayerCount() const
+{
+    return static_cast<int>(layers.size());
+}
+
+void CompositeNode::setLayerImage(int index, const cv::Mat &image)
+{
+    if (index < 0)
+    {
+        std::cerr << "Invalid layer index " << index << " in CompositeNode: " << name << std::endl;
+        return;
+    }
+
+    if (index >= static_cast<int>(layers.size()))
+        layers.resize(index + 1);
+
+    layers[index].image = image;
+    layers[index].connected = false;
+    markDirty();
+}
+
+void CompositeNode::setLayerMode(int index, BlendNode::BlendMode mode)
+{
+    if (!isValidLayer(index))
+        return;
+
+    layers[index].mode = mode;
+    markDirty();
+}
+
+void CompositeNode::setLayerOpacity(int index, float value)
+{
+    if (!isValidLayer(index))
+        return;
+
+    layers[index].opacity = std::max(0.0f, std::min(value, 1.0f));
+    markDirty();
+}
+
+void CompositeNode::setInput(const cv::Mat &image)
+{
+    setLayerImage(0, image);
+}
+
+void CompositeNode::setInputAt(int port, const cv::Mat &image)
+{
+    setLayerImage(port, image);
+    if (port >= 0)
+        layers[port].connected = true; // The graph hashes this image into the cache key
+}
+
+bool CompositeNode::isValidLayer(int index) const
+{
+    if (index < 0 || index >= static_cast<int>(layers.size()))
+    {
+        std::cerr << "Invalid layer index " << index << " in CompositeNode: " << name << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Composites the layer stack. Layers are only resized when they do not match the
+// background; the blending itself happens tile by tile (a strip of one row), so each
+// output tile stays in cache while every layer is applied to it.
+void CompositeNode::process()
+{
+    if (layers.empty() || layers[0].image.empty())
+    {
+        std::cerr << "No background layer set in CompositeNode: " << name << std::endl;
+        outputImage.release();
+        return;
+    }
+
+    const cv::Mat &background = layers[0].image;
+    std::vector<cv::Mat> images(layers.size());
+    images[0] = background;
+    bool sameType = true;
+
+    for (size_t i = 1; i < layers.size(); i++)
+    {
+        const cv::Mat &image = layers[i].image;
+
+        // Unset layers are left out of the stack
+        if (image.empty())
+            continue;
+
+        if (image.channels() != background.channels())
+        {
+            std::cerr << "Layer " << i << " has " << image.channels() << " channels but the background has "
+                      << background.channels() << " in CompositeNode: " << name << std::endl;
+            outputImage.release();
+            return;
+        }
+
+        images[i] = image;
+        if (image.size() != background.size())
+        {
+            cv::resize(image, images[i], background.size()); // Resize to ensure the layers have the same size
+        }
+
+        sameType = sameType && image.type() == background.type();
+    }
+
+    if (sameType && (background.depth() == CV_8U || background.depth() == CV_16U))
+    {
+        compositeFixedPoint(images);
+    }
+    else
+    {
+        compositeFloat(images);
+    }
+}
+
+void CompositeNode::compositeFixedPoint(const std::vector<cv::Mat> &images)
+{
+    const cv::Mat &background = images[0];
+    const int channels = background.channels();
+    const bool sixteenBit = background.depth() == CV_16U;
+    const float one = sixteenBit ? 65535.0f : 255.0f;
+
+    std::vector<int> opacities(layers.size());
+    for (size_t i = 0; i < layers.size(); i++)
+    {
+        opacities[i] = cvRound(layers[i].opacity * one);
+    }
+
+    cv::Mat result(background.size(), background.type());
+
+    cv::parallel_for_(cv::Range(0, background.rows), [&](const cv::Range &rows)
+                      {
+        for (int y = rows.start; y < rows.end; y++)
+        {
+            for (int x = 0; x < background.cols; x += tileColumns)
+            {
+                const int start = x * channels;
+                const int length = std::min(tileColumns, background.cols - x) * channels;
+                std::memcpy(result.ptr(y) + start * background.elemSize1(), background.ptr(y) + start * background.elemSize1(),
+                            length * background.elemSize1());
+
+                for (size_t i = 1; i < images.size(); i++)
+                {
+                    if (images[i].empty())
+                        continue;
+
+                    if (sixteenBit)
+                    {
+                        ushort *tile = result.ptr<ushort>(y) + start;
+                        BlendNode::blendRow16U(tile, images[i].ptr<ushort>(y) + start, tile, length, layers[i].mode, opacities[i]);
+                    }
+                    else
+                    {
+                        uchar *tile = result.ptr<uchar>(y) + start;
+                        BlendNode::blendRow8U(tile, images[i].ptr<uchar>(y) + start, tile, length, layers[i].mode, opacities[i]);
+                    }
+                }
+            }
+        } });
+
+    outputImage = result;
+}
+
+// Follows BlendNode's float path: every layer is normalized with BlendNode::unitScale for
+// its own depth, and the result is always written as BlendNode::floatOutputDepth.
+void CompositeNode::compositeFloat(const std::vector<cv::Mat> &images)
+{
+    const cv::Mat &background = images[0];
+    const int channels = background.channels();
+    const int outputDepth = BlendNode::floatOutputDepth;
+    cv::Mat result(background.size(), CV_MAKETYPE(outputDepth, channels));
+
+    cv::parallel_for_(cv::Range(0, background.rows), [&](const cv::Range &rows)
+                      {
+        // Per-band scratch tiles for the running composite and the current layer
+        cv::Mat accumulated(1, tileColumns, CV_MAKETYPE(CV_32F, channels));
+        cv::Mat layerTile(1, tileColumns, CV_MAKETYPE(CV_32F, channels));
+
+        for (int y = rows.start; y < rows.end; y++)
+        {
+            for (int x = 0; x < background.cols; x += tileColumns)
+            {
+                const cv::Range columns(x, std::min(x + tileColumns, background.cols));
+                cv::Mat accumulatedTile = accumulated.colRange(0, columns.size());
+                cv::Mat currentTile = layerTile.colRange(0, columns.size());
+                const int length = columns.size() * channels;
+
+                background.row(y).colRange(columns).convertTo(accumulatedTile, CV_32F, BlendNode::unitScale(background.depth()));
+
+                for (size_t i = 1; i < images.size(); i++)
+                {
+                    if (images[i].empty())
+                        continue;
+
+                    images[i].row(y).colRange(columns).convertTo(currentTile, CV_32F, BlendNode::unitScale(images[i].depth()));
+                    BlendNode::blendRow32F(accumulatedTile.ptr<float>(), currentTile.ptr<float>(), accumulatedTile.ptr<float>(),
+                                           length, layers[i].mode, layers[i].opacity);
+                }
+
+                cv::Mat resultTile = result.row(y).colRange(columns);
+                accumulatedTile.convertTo(resultTile, result.type(), 1.0 / BlendNode::unitScale(outputDepth));
+            }
+        } });
+
+    outputImage = result;
+}
+
+// Renders the UI for each layer above the background.
+void CompositeNode::renderUI()
+{
+    const char *blendNames[] = {"Normal", "Multiply", "Screen", "Overlay", "Difference"};
+
+    for (size_t i = 1; i < layers.size(); i++)
+    {
+        ImGui::PushID(static_cast<int>(i));
+        ImGui::Text("Layer %d", static_cast<int>(i));
+
+        if (ImGui::Combo("Blend Mode", reinterpret_cast<int *>(&layers[i].mode), blendNames, IM_ARRAYSIZE(blendNames)))
+        {
+            markDirty(); // Recomposite if the mode is changed
+        }
+
+        if (ImGui::SliderFloat("Opacity", &layers[i].opacity, 0.0f, 1.0f))
+        {
+            markDirty(); // Recomposite if the opacity is changed
+        }
+
+        ImGui::PopID();
+    }
+}
+
+cv::Mat CompositeNode::getOutput() const
+{
+    return outputImage;
+}
+
+void CompositeNode::setOutput(const cv::Mat &output)
+{
+    outputImage = output;
+}
+
+// Builds the cache key from the mode and opacity of every layer. Layers fed by a graph
+// connection reach the key through the graph's input hashes; every other layer image is
+// hashed here.
+std::string CompositeNode::getCacheKey() const
+{
+    std::ostringstream key;
+    key.precision(9);
+    key << layers.size();
+    for (const Layer &layer : layers)
+    {
+        key << '|' << layer.mode << ':' << layer.opacity << ':' << !layer.image.empty();
+        if (!layer.connected && !layer.image.empty())
+        {
+            key << ':' << std::hex << ResultCache::hashImage(layer.image) << std::dec;
+        }
+    }
+    return key.str();
+}
+
+// The cache key already covers every layer that is not fed by a connection.
+bool CompositeNode::getInputImages(std::vector<cv::Mat> &images) const
+{
+    images.clear();
+    return true;
+}
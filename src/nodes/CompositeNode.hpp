@@ -0,0 +1,83 @@
+#pragma once
+#include "../graph/Node.hpp"
+#include "BlendNode.hpp"
+#include <opencv2/opencv.hpp>
+#include <vector>
+
+// The CompositeNode flattens an ordered stack of layers in a single pass, using the same
+// blend modes and opacity semantics as BlendNode. Layer 0 is the background; every
+// following layer is blended over the result of the layers beneath it.
+class CompositeNode : public Node
+{
+public:
+    // A single layer of the stack
+    struct Layer
+    {
+        cv::Mat image;                                  // Layer pixels, resized to the background if needed
+        BlendNode::BlendMode mode = BlendNode::NORMAL; // Blend mode applied over the layers beneath
+        float opacity = 1.0f;                           // 0.0 to 1.0
+        bool connected = false;                         // Image delivered by a graph connection
+    };
+
+    // Constructor: Initializes the CompositeNode with a given name.
+    CompositeNode(const std::string &name);
+
+    // Appends a layer on top of the stack.
+    void addLayer(const cv::Mat &image, BlendNode::BlendMode mode = BlendNode::NORMAL, float opacity = 1.0f);
+
+    // Removes the layer at the given index.
+    void removeLayer(int index);
+
+    // Returns the number of layers, including the background.
+    int getLayerCount() const;
+
+    // Replaces the image of a layer, growing the stack if the index is past the top.
+    void setLayerImage(int index, const cv::Mat &image);
+
+    // Sets the blend mode of a layer.
+    void setLayerMode(int index, BlendNode::BlendMode mode);
+
+    // Sets the opacity of a layer, where 0.0 hides it and 1.0 applies it fully.
+    void setLayerOpacity(int index, float value);
+
+    // Sets the background layer.
+    void setInput(const cv::Mat &image) override;
+
+    // Graph port routing: port i is layer i.
+    void setInputAt(int port, const cv::Mat &image) override;
+
+    // Composites every layer into the output image.
+    void process() override;
+
+    // Renders the mode and opacity controls of every layer above the background.
+    void renderUI() override;
+
+    // Returns the composited image.
+    cv::Mat getOutput() const override;
+
+    // Restores a cached composite.
+    void setOutput(const cv::Mat &output) override;
+
+    // Serializes the mode and opacity of every layer, plus a content hash of every layer
+    // not fed by a connection, for the graph's result cache.
+    std::string getCacheKey() const override;
+
+    // Reports no images, since getCacheKey already hashes the directly set layers.
+    bool getInputImages(std::vector<cv::Mat> &images) const override;
+
+private:
+    // Composites 8-bit or 16-bit stacks of one type with the fixed-point row kernels.
+    void compositeFixedPoint(const std::vector<cv::Mat> &images);
+
+    // Composites any other stack in 32-bit float, converting one tile of each layer at a time.
+    void compositeFloat(const std::vector<cv::Mat> &images);
+
+    // Returns true if index refers to an existing layer, printing an error otherwise.
+    bool isValidLayer(int index) const;
+
+    // The layer stack, bottom first
+    std::vector<Layer> layers;
+
+    // The flattened result
+    cv::Mat outputImage;
+};
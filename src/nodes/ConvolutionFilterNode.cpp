@@ -1,5 +1,13 @@
 #include "ConvolutionFilterNode.hpp"
+#include <opencv2/core/hal/intrin.hpp>
 #include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iterator>
+#include <limits>
+#include <utility>
 
 // Constructor: Initializes the node with an id and name, and sets the node type to Processing
 ConvolutionFilterNode::ConvolutionFilterNode(const std::string &id, const std::string &name)
@@ -7,25 +15,33 @@ ConvolutionFilterNode::ConvolutionFilterNode(const std::string &id, const std::s
     this->id = id;
     this->name = name;
     this->nodeType = NodeType::Processing;
+    kernelData.assign(kernelSize * kernelSize, 0.0f); // Start from an all-zero kernel
 }
 
-// Sets the kernel size for the convolution filter (either 3x3 or 5x5)
+// Sets the kernel size for the convolution filter; any odd size has a center pixel
 void ConvolutionFilterNode::setKernelSize(int size)
 {
-    if (size == 3 || size == 5)
+    if (size < 1 || size % 2 == 0)
     {
-        kernelSize = size;
-        kernelData.resize(size * size, 0.0f); // Initialize kernel data with zeroes
+        std::cerr << "Kernel size must be odd and positive, got " << size << " in ConvolutionFilterNode: " << name << std::endl;
+        return;
     }
+
+    kernelSize = size;
+    kernelData.assign(size * size, 0.0f); // Initialize kernel data with zeroes
+    invalidatePlan();
+    markDirty();
 }
 
 // Sets a custom kernel (used when the user wants to define their own filter)
 void ConvolutionFilterNode::setCustomKernel(const std::vector<float> &data)
 {
-    if (data.size() == kernelSize * kernelSize)
+    if (data.size() == static_cast<size_t>(kernelSize * kernelSize))
     {
         kernelData = data; // Store the custom kernel data
         preset = PresetType::Custom; // Mark this as a custom preset
+        invalidatePlan();
+        markDirty();
     }
 }
 
@@ -34,18 +50,79 @@ void ConvolutionFilterNode::setPreset(PresetType type)
 {
     preset = type;
     loadPreset(type); // Load the chosen preset kernel
+    invalidatePlan();
+    markDirty();
+}
+
+// Sets the kernel size from which the FFT path is planned; 0 disables it
+void ConvolutionFilterNode::setFftThreshold(int size)
+{
+    fftThreshold = std::max(0, size);
+    invalidatePlan();
+    markDirty();
+}
+
+// Plans the current kernel if needed and reports the chosen method
+ConvolutionFilterNode::Method ConvolutionFilterNode::getMethod()
+{
+    if (!planned)
+        planKernel();
+    return integerWeights.empty() ? method : Method::Integer;
+}
+
+void ConvolutionFilterNode::invalidatePlan()
+{
+    planned = false;
+    columnKernels.clear();
+    rowKernels.clear();
+    kernelSpectrum.release();
 }
 
 // Sets the input image for processing
 void ConvolutionFilterNode::setInput(const cv::Mat &input)
 {
     inputImage = input.clone(); // Clone the input image to avoid modifying the original
+    planarInput.release();      // An interleaved input replaces a planar one
+    invalidate();               // A new input must be filtered on the next evaluation
+}
+
+// Stores a planar input image, replacing any interleaved one
+void ConvolutionFilterNode::setPlanarInputAt(int port, const PlanarImage &input)
+{
+    planarInput = input;
+    inputImage.release();
+    invalidate();
 }
 
 // Applies the selected kernel to the input image and produces the output
 void ConvolutionFilterNode::process()
 {
-    applyKernel(); // Apply the selected kernel to the image
+    if (planarInput.empty() && !isPlanarOutputRequested())
+    {
+        applyKernel(inputImage, outputImage); // Apply the selected kernel to the image
+        planarOutput.release();
+        return;
+    }
+
+    // Filter plane by plane; an interleaved input is split once here
+    PlanarImage source = planarInput.empty() ? PlanarImage::fromInterleaved(inputImage) : planarInput;
+    std::vector<cv::Mat> planes(source.channels());
+    for (int c = 0; c < source.channels(); c++)
+    {
+        applyKernel(source.plane(c), planes[c]);
+    }
+
+    PlanarImage result(std::move(planes));
+    if (isPlanarOutputRequested())
+    {
+        planarOutput = result;
+        outputImage.release();
+    }
+    else
+    {
+        outputImage = result.toInterleaved();
+        planarOutput.release();
+    }
 }
 
 // Renders the user interface (currently just a placeholder for rendering logic)
@@ -58,20 +135,545 @@ void ConvolutionFilterNode::renderUI()
 // Returns the resulting image after convolution
 cv::Mat ConvolutionFilterNode::getOutput() const
 {
+    // A planar result is interleaved on demand
+    if (outputImage.empty() && !planarOutput.empty())
+    {
+        return planarOutput.toInterleaved();
+    }
     return outputImage; // Return the processed image
 }
 
-// Applies the chosen kernel to the input image using OpenCV's filter2D function
-void ConvolutionFilterNode::applyKernel()
+// Restores a previously computed output image
+void ConvolutionFilterNode::setOutput(const cv::Mat &output)
+{
+    outputImage = output;
+    planarOutput.release();
+}
+
+// Every channel is filtered on its own, so planar data can flow through
+bool ConvolutionFilterNode::supportsPlanar() const
+{
+    return true;
+}
+
+// Returns the output as planes, splitting an interleaved result on demand
+PlanarImage ConvolutionFilterNode::getPlanarOutput() const
 {
-    if (inputImage.empty())
+    if (planarOutput.empty())
+    {
+        return PlanarImage::fromInterleaved(outputImage);
+    }
+    return planarOutput;
+}
+
+// Builds the cache key from the kernel size and weights
+std::string ConvolutionFilterNode::getCacheKey() const
+{
+    std::ostringstream key;
+    key.precision(9);
+    key << kernelSize << '|' << fftThreshold; // The FFT path rounds differently from filter2D
+    for (float weight : kernelData)
+    {
+        key << '|' << weight;
+    }
+    return key.str();
+}
+
+bool ConvolutionFilterNode::getInputImages(std::vector<cv::Mat> &images) const
+{
+    images = {inputImage};
+    return true;
+}
+
+namespace
+{
+    // Singular values below this fraction of the largest are treated as zero
+    const double rankTolerance = 1e-5;
+
+    // Smallest kernel for which the FFT path is ever considered or calibrated
+    const int minFftKernelSize = 7;
+
+    // The integer path evaluates every tap, so it is kept to kernels below the area at which
+    // filter2D switches to a DFT (7x7 and smaller); larger ones stay with filter2D
+    const int integerKernelAreaLimit = 50;
+
+    // Preset weights, shared by loadPreset and the specialized kernels below
+    struct SharpenWeights
+    {
+        static constexpr int weights[9] = {
+            0, -1, 0,
+            -1, 5, -1,
+            0, -1, 0};
+    };
+
+    struct EmbossWeights
+    {
+        static constexpr int weights[9] = {
+            -2, -1, 0,
+            -1, 1, 1,
+            0, 1, 2};
+    };
+
+    // One tap of a 3x3 kernel known at compile time; zero weights vanish entirely
+    template <typename Weights, size_t Tap>
+    inline int weightedTap(const uchar *const *rows, int element, int channels)
+    {
+        constexpr int weight = Weights::weights[Tap];
+        if constexpr (weight == 0)
+            return 0;
+        else
+            return weight * rows[Tap / 3][element + static_cast<int>(Tap % 3) * channels];
+    }
+
+    template <typename Weights, size_t... Taps>
+    inline int weightedSum(const uchar *const *rows, int element, int channels, std::index_sequence<Taps...>)
+    {
+        return (0 + ... + weightedTap<Weights, Taps>(rows, element, channels));
+    }
+
+#if CV_SIMD
+    // Vector form of weightedTap: one vector of 8-bit samples widened to four int32 vectors
+    // and added into `sums`. Zero weights emit nothing and unit weights no multiply.
+    template <typename Weights, size_t Tap>
+    inline void accumulateTap(const uchar *const *rows, int element, int channels, cv::v_int32 (&sums)[4])
+    {
+        using namespace cv;
+        constexpr int weight = Weights::weights[Tap];
+        if constexpr (weight != 0)
+        {
+            v_uint16 low, high;
+            v_expand(vx_load(rows[Tap / 3] + element + static_cast<int>(Tap % 3) * channels), low, high);
+            v_int32 samples[4];
+            v_expand(v_reinterpret_as_s16(low), samples[0], samples[1]);
+            v_expand(v_reinterpret_as_s16(high), samples[2], samples[3]);
+            for (int k = 0; k < 4; k++)
+            {
+                if constexpr (weight == 1)
+                    sums[k] = sums[k] + samples[k];
+                else if constexpr (weight == -1)
+                    sums[k] = sums[k] - samples[k];
+                else
+                    sums[k] = sums[k] + samples[k] * vx_setall_s32(weight);
+            }
+        }
+    }
+
+    template <typename Weights, size_t... Taps>
+    inline void accumulateTaps(const uchar *const *rows, int element, int channels, cv::v_int32 (&sums)[4],
+                               std::index_sequence<Taps...>)
+    {
+        (accumulateTap<Weights, Taps>(rows, element, channels, sums), ...);
+    }
+#endif
+
+    // 3x3 correlation with compile-time integer weights. Whole vectors are summed in int32
+    // lanes by a fold over the non-zero taps and narrowed with v_pack and v_pack_u, which
+    // saturate like saturate_cast; the scalar fold handles the tail. The integer sum is
+    // exact, so both match filter2D on 8-bit images (bench/ConvolutionBenchmark checks this).
+    template <typename Weights>
+    void filter3x3(const cv::Mat &padded, cv::Mat &destination)
+    {
+        const int channels = padded.channels();
+        const int length = destination.cols * channels;
+
+        cv::parallel_for_(cv::Range(0, destination.rows), [&](const cv::Range &band)
+                          {
+            for (int y = band.start; y < band.end; y++)
+            {
+                const uchar *rows[3] = {padded.ptr<uchar>(y), padded.ptr<uchar>(y + 1), padded.ptr<uchar>(y + 2)};
+                uchar *dst = destination.ptr<uchar>(y);
+                int e = 0;
+#if CV_SIMD
+                for (; e <= length - CV_SIMD_WIDTH; e += CV_SIMD_WIDTH)
+                {
+                    cv::v_int32 sums[4] = {cv::vx_setzero_s32(), cv::vx_setzero_s32(), cv::vx_setzero_s32(), cv::vx_setzero_s32()};
+                    accumulateTaps<Weights>(rows, e, channels, sums, std::make_index_sequence<9>());
+                    cv::v_store(dst + e, cv::v_pack_u(cv::v_pack(sums[0], sums[1]), cv::v_pack(sums[2], sums[3])));
+                }
+#endif
+                for (; e < length; e++)
+                {
+                    dst[e] = cv::saturate_cast<uchar>(weightedSum<Weights>(rows, e, channels, std::make_index_sequence<9>()));
+                }
+            }
+#if CV_SIMD
+            cv::vx_cleanup();
+#endif
+        });
+    }
+
+    // Kernels with a compile-time implementation, matched by their exact weights.
+    // EdgeEnhance uses the same weights as Sharpen and is served by its entry.
+    struct SpecializedKernel
+    {
+        const int *weights;
+        void (*filter)(const cv::Mat &padded, cv::Mat &destination);
+    };
+
+    const SpecializedKernel specializedKernels[] = {
+        {SharpenWeights::weights, &filter3x3<SharpenWeights>},
+        {EmbossWeights::weights, &filter3x3<EmbossWeights>},
+    };
+
+    // accumulator[e] += weight * source[e] over a row. With universal intrinsics each vector
+    // of 8-bit samples is widened to four int32 vectors for the multiply-add.
+    inline void multiplyAddRow(int *accumulator, const uchar *source, int weight, int length)
+    {
+        int e = 0;
+#if CV_SIMD
+        using namespace cv;
+        const int quarter = CV_SIMD_WIDTH / 4;
+        const v_int32 vweight = vx_setall_s32(weight);
+        for (; e <= length - CV_SIMD_WIDTH; e += CV_SIMD_WIDTH)
+        {
+            v_uint16 low, high;
+            v_expand(vx_load(source + e), low, high);
+            v_int32 a0, a1, a2, a3;
+            v_expand(v_reinterpret_as_s16(low), a0, a1);
+            v_expand(v_reinterpret_as_s16(high), a2, a3);
+            v_store(accumulator + e, vx_load(accumulator + e) + a0 * vweight);
+            v_store(accumulator + e + quarter, vx_load(accumulator + e + quarter) + a1 * vweight);
+            v_store(accumulator + e + 2 * quarter, vx_load(accumulator + e + 2 * quarter) + a2 * vweight);
+            v_store(accumulator + e + 3 * quarter, vx_load(accumulator + e + 3 * quarter) + a3 * vweight);
+        }
+#endif
+        for (; e < length; e++)
+            accumulator[e] += weight * source[e];
+    }
+
+    // destination[e] = saturate_cast<uchar>(accumulator[e]). The vector path packs with
+    // saturation to int16 and then to uint8, which clamps exactly like saturate_cast.
+    inline void storeSaturatedRow(uchar *destination, const int *accumulator, int length)
+    {
+        int e = 0;
+#if CV_SIMD
+        using namespace cv;
+        const int quarter = CV_SIMD_WIDTH / 4;
+        for (; e <= length - CV_SIMD_WIDTH; e += CV_SIMD_WIDTH)
+        {
+            v_int16 low = v_pack(vx_load(accumulator + e), vx_load(accumulator + e + quarter));
+            v_int16 high = v_pack(vx_load(accumulator + e + 2 * quarter), vx_load(accumulator + e + 3 * quarter));
+            v_store(destination + e, v_pack_u(low, high));
+        }
+#endif
+        for (; e < length; e++)
+            destination[e] = cv::saturate_cast<uchar>(accumulator[e]);
+    }
+
+    // Correlation with runtime integer weights, one tap at a time over an int row accumulator
+    void filterInteger(const cv::Mat &padded, cv::Mat &destination, const std::vector<int> &weights, int size)
+    {
+        const int channels = padded.channels();
+        const int length = destination.cols * channels;
+
+        cv::parallel_for_(cv::Range(0, destination.rows), [&](const cv::Range &band)
+                          {
+            std::vector<int> accumulator(length);
+            for (int y = band.start; y < band.end; y++)
+            {
+                std::fill(accumulator.begin(), accumulator.end(), 0);
+                for (int ky = 0; ky < size; ky++)
+                {
+                    const uchar *row = padded.ptr<uchar>(y + ky);
+                    for (int kx = 0; kx < size; kx++)
+                    {
+                        const int weight = weights[ky * size + kx];
+                        if (weight == 0)
+                            continue;
+
+                        multiplyAddRow(accumulator.data(), row + kx * channels, weight, length);
+                    }
+                }
+
+                storeSaturatedRow(destination.ptr<uchar>(y), accumulator.data(), length);
+            }
+#if CV_SIMD
+            cv::vx_cleanup();
+#endif
+        });
+    }
+
+    // Cross-correlates a single-channel image with the kernel through the DFT, matching
+    // filter2D with reflect-101 borders. The source is padded by the kernel radius, so the
+    // circular correlation never wraps into the pixels that are kept. `spectrum` caches the
+    // kernel's DFT and is recomputed when the padded size changes.
+    void correlateFFT(const cv::Mat &plane, const cv::Mat &kernel, cv::Mat &spectrum, cv::Mat &destination)
+    {
+        const int radius = kernel.rows / 2;
+        cv::Mat padded;
+        cv::copyMakeBorder(plane, padded, radius, radius, radius, radius, cv::BORDER_REFLECT_101);
+
+        cv::Size dftSize(cv::getOptimalDFTSize(padded.cols), cv::getOptimalDFTSize(padded.rows));
+        if (spectrum.size() != dftSize)
+        {
+            cv::Mat kernelPadded = cv::Mat::zeros(dftSize, CV_32F);
+            cv::Mat kernelRegion = kernelPadded(cv::Rect(0, 0, kernel.cols, kernel.rows));
+            kernel.copyTo(kernelRegion);
+            cv::dft(kernelPadded, spectrum, 0, kernel.rows);
+        }
+
+        cv::Mat image = cv::Mat::zeros(dftSize, CV_32F);
+        cv::Mat imageRegion = image(cv::Rect(0, 0, padded.cols, padded.rows));
+        padded.convertTo(imageRegion, CV_32F);
+
+        // Multiplying by the conjugate kernel spectrum correlates instead of convolving
+        cv::dft(image, image, 0, padded.rows);
+        cv::mulSpectrums(image, spectrum, image, 0, true);
+        cv::idft(image, image, cv::DFT_SCALE | cv::DFT_REAL_OUTPUT, plane.rows);
+
+        image(cv::Rect(0, 0, plane.cols, plane.rows)).convertTo(destination, plane.depth());
+    }
+
+    // Best of a few runs, in ticks
+    template <typename Function>
+    int64 timeBest(Function function)
+    {
+        int64 best = std::numeric_limits<int64>::max();
+        for (int run = 0; run < 3; run++)
+        {
+            int64 start = cv::getTickCount();
+            function();
+            best = std::min(best, cv::getTickCount() - start);
+        }
+        return best;
+    }
+}
+
+// Runs on a 256x256 float image, growing the kernel until the FFT path beats filter2D.
+// filter2D itself switches to a DFT once the kernel area reaches 50 taps (130 for 8-bit
+// and float images on SSE3 CPUs), so from 9x9 or 13x13 on this compares one DFT against
+// another. The two are close and the result can change from run to run; treat it as a
+// hint for setFftThreshold, not a property of the machine.
+int ConvolutionFilterNode::calibrateFftThreshold()
+{
+    cv::Mat image(256, 256, CV_32F);
+    cv::randu(image, 0.0f, 1.0f);
+    cv::Mat result;
+
+    for (int size = minFftKernelSize; size <= 63; size += 8)
+    {
+        cv::Mat kernel(size, size, CV_32F);
+        cv::randu(kernel, -1.0f, 1.0f);
+        cv::Mat spectrum;
+
+        int64 direct = timeBest([&]() { cv::filter2D(image, result, -1, kernel); });
+        int64 fft = timeBest([&]() { correlateFFT(image, kernel, spectrum, result); });
+        if (fft < direct)
+            return size;
+    }
+
+    return 0; // filter2D was faster at every measured size
+}
+
+// Small all-integer kernels run exactly in integer arithmetic on 8-bit images whatever
+// their rank, so a box or other separable integer kernel is checked before the SVD plan
+// can claim it. The float plan is still made for images of other depths.
+void ConvolutionFilterNode::planKernel()
+{
+    integerWeights.clear();
+    specializedFilter = nullptr;
+    planIntegerKernel();
+    planFloatKernel();
+}
+
+// Picks the cheapest method from estimated multiplies per pixel. The SVD gives the kernel's
+// rank r: r separable terms cost 2nr against n^2 for filter2D. The FFT cost hardly depends on
+// the kernel size, so it is taken as the direct cost at the configured threshold.
+void ConvolutionFilterNode::planFloatKernel()
+{
+    planned = true;
+    method = Method::Direct;
+    columnKernels.clear();
+    rowKernels.clear();
+    kernelSpectrum.release();
+
+    const int n = kernelSize;
+    if (n == 1 || kernelData.size() != static_cast<size_t>(n * n))
+        return;
+
+    cv::Mat kernel(n, n, CV_32F, kernelData.data());
+    cv::Mat kernel64, singularValues, u, vt;
+    kernel.convertTo(kernel64, CV_64F);
+    cv::SVD::compute(kernel64, singularValues, u, vt);
+
+    const double largest = singularValues.at<double>(0);
+    if (largest <= 0.0)
+        return; // All-zero kernel
+
+    int rank = 0;
+    while (rank < n && singularValues.at<double>(rank) > largest * rankTolerance)
+        rank++;
+
+    const double directCost = static_cast<double>(n) * n;
+    const double separableCost = 2.0 * n * rank;
+    double fftCost = std::numeric_limits<double>::infinity();
+    if (fftThreshold > 0 && n >= std::max(fftThreshold, minFftKernelSize))
+    {
+        const int threshold = std::max(fftThreshold, minFftKernelSize);
+        fftCost = static_cast<double>(threshold) * threshold;
+    }
+
+    if (separableCost < directCost && separableCost <= fftCost)
+    {
+        method = rank == 1 ? Method::Separable : Method::LowRank;
+
+        // kernel = sum of s_i * u_i * v_i^T; each term splits its weight evenly between the passes
+        for (int i = 0; i < rank; i++)
+        {
+            double weight = std::sqrt(singularValues.at<double>(i));
+            cv::Mat column, row;
+            cv::Mat(u.col(i) * weight).convertTo(column, CV_32F);
+            cv::Mat(vt.row(i) * weight).convertTo(row, CV_32F);
+            columnKernels.push_back(column);
+            rowKernels.push_back(row);
+        }
+    }
+    else if (fftCost < directCost)
+    {
+        method = Method::FFT;
+    }
+}
+
+// Integer weights give exact sums as long as the largest possible sum fits in an int
+void ConvolutionFilterNode::planIntegerKernel()
+{
+    if (kernelData.size() != static_cast<size_t>(kernelSize * kernelSize) ||
+        kernelSize * kernelSize >= integerKernelAreaLimit)
+        return;
+
+    std::vector<int> weights(kernelData.size());
+    long long absoluteSum = 0;
+    for (size_t i = 0; i < kernelData.size(); i++)
+    {
+        const float weight = kernelData[i];
+        if (weight != std::round(weight) || std::abs(weight) > 65536.0f)
+            return;
+
+        weights[i] = static_cast<int>(weight);
+        absoluteSum += std::abs(weights[i]);
+    }
+
+    if (absoluteSum * 255 > std::numeric_limits<int>::max())
+        return;
+
+    integerWeights = std::move(weights);
+
+    if (kernelSize == 3)
+    {
+        for (const SpecializedKernel &kernel : specializedKernels)
+        {
+            if (std::equal(integerWeights.begin(), integerWeights.end(), kernel.weights))
+            {
+                specializedFilter = kernel.filter;
+                break;
+            }
+        }
+    }
+}
+
+// Applies the chosen kernel to one image with the method picked by the planner
+void ConvolutionFilterNode::applyKernel(const cv::Mat &source, cv::Mat &destination)
+{
+    if (source.empty())
         return; // Ensure the input image is not empty
 
-    // Create a CV_32F matrix for the kernel from the kernel data
-    cv::Mat kernel(kernelSize, kernelSize, CV_32F, const_cast<float *>(kernelData.data()));
+    if (kernelData.size() != static_cast<size_t>(kernelSize * kernelSize))
+    {
+        std::cerr << "Kernel has " << kernelData.size() << " weights but its size is " << kernelSize
+                  << " in ConvolutionFilterNode: " << name << std::endl;
+        return;
+    }
+
+    if (!planned)
+        planKernel();
+
+    if (!integerWeights.empty() && source.depth() == CV_8U)
+    {
+        applyInteger(source, destination);
+        return;
+    }
+
+    switch (method)
+    {
+    case Method::Separable:
+    case Method::LowRank:
+        applySeparable(source, destination);
+        break;
+    case Method::FFT:
+        applyFFT(source, destination);
+        break;
+    default:
+    {
+        // Create a CV_32F matrix for the kernel from the kernel data
+        cv::Mat kernel(kernelSize, kernelSize, CV_32F, kernelData.data());
 
-    // Apply the kernel using filter2D to perform the convolution
-    cv::filter2D(inputImage, outputImage, -1, kernel);
+        // Apply the kernel using filter2D to perform the convolution
+        cv::filter2D(source, destination, -1, kernel);
+        break;
+    }
+    }
+}
+
+// A rank-1 kernel runs as a single sepFilter2D call. Low-rank kernels sum their terms in
+// float and round once at the end, as filter2D does.
+void ConvolutionFilterNode::applySeparable(const cv::Mat &source, cv::Mat &destination)
+{
+    if (columnKernels.size() == 1)
+    {
+        cv::sepFilter2D(source, destination, -1, rowKernels[0], columnKernels[0]);
+        return;
+    }
+
+    const int accumulatorDepth = source.depth() == CV_64F ? CV_64F : CV_32F;
+    cv::Mat sum, term;
+    for (size_t i = 0; i < columnKernels.size(); i++)
+    {
+        cv::sepFilter2D(source, i == 0 ? sum : term, accumulatorDepth, rowKernels[i], columnKernels[i]);
+        if (i > 0)
+            sum += term;
+    }
+    sum.convertTo(destination, source.depth());
+}
+
+// The source is padded once with reflect-101 borders, filter2D's default, so the kernels
+// read every neighbour directly
+void ConvolutionFilterNode::applyInteger(const cv::Mat &source, cv::Mat &destination)
+{
+    const int radius = kernelSize / 2;
+    cv::Mat padded;
+    cv::copyMakeBorder(source, padded, radius, radius, radius, radius, cv::BORDER_REFLECT_101);
+
+    // A fresh destination, so a destination aliasing the source is never written while read
+    cv::Mat result(source.size(), source.type());
+    if (specializedFilter)
+    {
+        specializedFilter(padded, result);
+    }
+    else
+    {
+        filterInteger(padded, result, integerWeights, kernelSize);
+    }
+    destination = result;
+}
+
+// Multi-channel images are correlated one channel at a time and merged back
+void ConvolutionFilterNode::applyFFT(const cv::Mat &source, cv::Mat &destination)
+{
+    cv::Mat kernel(kernelSize, kernelSize, CV_32F, kernelData.data());
+
+    if (source.channels() == 1)
+    {
+        correlateFFT(source, kernel, kernelSpectrum, destination);
+        return;
+    }
+
+    std::vector<cv::Mat> channels;
+    cv::split(source, channels);
+    for (cv::Mat &channel : channels)
+    {
+        correlateFFT(channel, kernel, kernelSpectrum, channel);
+    }
+    cv::merge(channels, destination);
 }
 
 // Loads the appropriate preset kernel based on the preset type
@@ -81,24 +683,15 @@ void ConvolutionFilterNode::loadPreset(PresetType type)
     {
     case PresetType::Sharpen:
         kernelSize = 3; // Set kernel size to 3x3
-        kernelData = {
-            0, -1, 0,
-            -1, 5, -1,
-            0, -1, 0}; // Sharpen kernel
+        kernelData.assign(std::begin(SharpenWeights::weights), std::end(SharpenWeights::weights)); // Sharpen kernel
         break;
     case PresetType::Emboss:
         kernelSize = 3; // Set kernel size to 3x3
-        kernelData = {
-            -2, -1, 0,
-            -1, 1, 1,
-            0, 1, 2}; // Emboss kernel
+        kernelData.assign(std::begin(EmbossWeights::weights), std::end(EmbossWeights::weights)); // Emboss kernel
         break;
     case PresetType::EdgeEnhance:
         kernelSize = 3; // Set kernel size to 3x3
-        kernelData = {
-            0, -1, 0,
-            -1, 5, -1,
-            0, -1, 0}; // Edge enhancement kernel
+        kernelData.assign(std::begin(SharpenWeights::weights), std::end(SharpenWeights::weights)); // Edge enhancement kernel
         break;
     default:
         break;
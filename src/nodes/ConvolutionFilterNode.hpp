@@ -11,10 +11,19 @@ public:
     // Enum for the available preset filter types
     enum class PresetType { Custom, Sharpen, Emboss, EdgeEnhance };
 
+    // How the kernel is applied, planned from its rank and size whenever it changes
+    enum class Method {
+        Direct,     // cv::filter2D
+        Integer,    // Exact integer arithmetic for all-integer weights on 8-bit images
+        Separable,  // Rank 1: one column pass and one row pass
+        LowRank,    // A sum of separable passes, one per singular value
+        FFT         // Correlation in the frequency domain, for large dense kernels
+    };
+
     // Constructor: Initializes the node with a unique ID and display name
     ConvolutionFilterNode(const std::string& id, const std::string& name);
 
-    // Sets the kernel size (only 3x3 or 5x5 supported)
+    // Sets the kernel size (any odd size) and clears the weights
     void setKernelSize(int size);
 
     // Sets a custom kernel (user-defined filter weights)
@@ -23,6 +32,19 @@ public:
     // Applies a predefined filter by setting the corresponding preset
     void setPreset(PresetType type);
 
+    // Sets the kernel size from which the FFT path is considered. 0 (the default) never
+    // plans it: filter2D already switches to its own DFT for large kernels.
+    void setFftThreshold(int size);
+
+    // Times filter2D against the FFT path on this machine and returns the first kernel size
+    // where the FFT path won, or 0 if it never did. Never run implicitly: call it while the
+    // machine is otherwise idle and pass the result to setFftThreshold.
+    static int calibrateFftThreshold();
+
+    // Returns the method the planner chose for the current kernel; an Integer plan applies
+    // to 8-bit images, and other depths use the best float method
+    Method getMethod();
+
     // Sets the input image for the convolution operation
     void setInput(const cv::Mat& input) override;
 
@@ -35,17 +57,65 @@ public:
     // Returns the processed (filtered) output image
     cv::Mat getOutput() const override;
 
+    // Restores a cached output image
+    void setOutput(const cv::Mat& output) override;
+
+    // Serializes the kernel for the graph's result cache
+    std::string getCacheKey() const override;
+
+    // The input image, hashed into the cache key when it was set directly
+    bool getInputImages(std::vector<cv::Mat> &images) const override;
+
+    // The kernel is applied to every channel independently, so the node can stay planar
+    bool supportsPlanar() const override;
+    void setPlanarInputAt(int port, const PlanarImage& input) override;
+    PlanarImage getPlanarOutput() const override;
+
 private:
-    // Internal method that applies the kernel to the input image using OpenCV
-    void applyKernel();
+    // Internal method that applies the kernel to one image (interleaved or a single plane) using OpenCV
+    void applyKernel(const cv::Mat& source, cv::Mat& destination);
 
     // Loads weights for a predefined kernel based on the selected preset
     void loadPreset(PresetType type);
 
-    int kernelSize = 3;                       // Size of the kernel (3 or 5)
+    // Chooses the method for the current kernel and precomputes its separable terms
+    void planKernel();
+    void planFloatKernel();
+
+    // Fills integerWeights for kernels up to 7x7 whose weights are all small integers
+    void planIntegerKernel();
+
+    // Forgets the plan and the cached kernel spectrum after the kernel changes
+    void invalidatePlan();
+
+    // Applies the separable terms of the plan, summing them for low-rank kernels
+    void applySeparable(const cv::Mat& source, cv::Mat& destination);
+
+    // Correlates every channel with the kernel in the frequency domain
+    void applyFFT(const cv::Mat& source, cv::Mat& destination);
+
+    // Filters an 8-bit image with the integer weights, through a specialized kernel when one matches
+    void applyInteger(const cv::Mat& source, cv::Mat& destination);
+
+    int kernelSize = 3;                       // Size of the kernel (odd)
     std::vector<float> kernelData;           // Flat vector representing the kernel weights
     PresetType preset = PresetType::Custom;  // Currently selected preset type
 
+    // Execution plan for the current kernel
+    bool planned = false;
+    Method method = Method::Direct;
+    int fftThreshold = 0;                // 0: never plan the FFT path
+    std::vector<cv::Mat> columnKernels;  // Per separable term: vertical (n x 1) weights
+    std::vector<cv::Mat> rowKernels;     // Per separable term: horizontal (1 x n) weights
+    cv::Mat kernelSpectrum;              // Kernel DFT for the FFT path, for the last padded size
+
+    // Filters a reflect-101 padded 8-bit image into a destination of the unpadded size
+    using SpecializedFilter = void (*)(const cv::Mat& padded, cv::Mat& destination);
+    std::vector<int> integerWeights;               // Kernel weights when 8-bit images use the Integer plan
+    SpecializedFilter specializedFilter = nullptr;  // Compile-time kernel matching the weights, if any
+
     cv::Mat inputImage;   // Input image to apply the filter on
     cv::Mat outputImage;  // Resulting image after applying the kernel
+    PlanarImage planarInput;   // Planar input, used instead of inputImage when set
+    PlanarImage planarOutput;  // Planar result, kept when every consumer takes planar input
 };
@@ -1,7 +1,93 @@
 #include "EdgeDetectionNode.hpp"
+#include "../graph/ResultCache.hpp"
 #include <opencv2/opencv.hpp>
+#include <opencv2/core/hal/intrin.hpp>
 #include <iostream>
 #include <imgui.h>
+#include <sstream>
+#include <vector>
+#include <mutex>
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // BORDER_REFLECT_101 index into [0, length)
+    inline int reflect101(int index, int length)
+    {
+        if (length == 1)
+            return 0;
+        if (index < 0)
+            return -index;
+        if (index >= length)
+            return 2 * length - 2 - index;
+        return index;
+    }
+
+    // Luminance of one source row into dst[1..cols], with reflected samples in dst[0] and dst[cols + 1].
+    // Uses cvtColor's 14-bit fixed-point BGR weights so the result matches COLOR_BGR2GRAY.
+    void lumaRow(const uchar *src, int channels, int cols, int *dst)
+    {
+        const int shift = 14;
+        const int blueWeight = 1868, greenWeight = 9617, redWeight = 4899;
+
+        if (channels == 1)
+        {
+            for (int x = 0; x < cols; x++)
+                dst[x + 1] = src[x];
+        }
+        else
+        {
+            for (int x = 0; x < cols; x++)
+            {
+                const uchar *pixel = src + x * channels;
+                dst[x + 1] = (pixel[0] * blueWeight + pixel[1] * greenWeight + pixel[2] * redWeight + (1 << (shift - 1))) >> shift;
+            }
+        }
+        dst[0] = dst[reflect101(-1, cols) + 1];
+        dst[cols + 1] = dst[reflect101(cols, cols) + 1];
+    }
+
+#if CV_SIMD
+    // Rounded Sobel magnitude for one vector of int32 lanes starting at the given luma positions
+    inline cv::v_int32 sobelMagnitudeLanes(const int *above, const int *center, const int *below)
+    {
+        using namespace cv;
+        const v_int32 aboveLeft = vx_load(above - 1), aboveMid = vx_load(above), aboveRight = vx_load(above + 1);
+        const v_int32 centerLeft = vx_load(center - 1), centerRight = vx_load(center + 1);
+        const v_int32 belowLeft = vx_load(below - 1), belowMid = vx_load(below), belowRight = vx_load(below + 1);
+
+        const v_int32 gx = (aboveRight + centerRight + centerRight + belowRight) - (aboveLeft + centerLeft + centerLeft + belowLeft);
+        const v_int32 gy = (belowLeft + belowMid + belowMid + belowRight) - (aboveLeft + aboveMid + aboveMid + aboveRight);
+        return v_round(v_sqrt(v_cvt_f32(gx * gx + gy * gy)));
+    }
+#endif
+
+    // One output row of saturate_cast<uchar>(|gradient|) from three padded luma rows. Whole
+    // vectors go through universal intrinsics and pack with saturation like saturate_cast.
+    void sobelMagnitudeRow(const int *above, const int *center, const int *below, uchar *dst, int cols)
+    {
+        int x = 0;
+#if CV_SIMD
+        using namespace cv;
+        const int quarter = CV_SIMD_WIDTH / 4;
+        for (; x <= cols - CV_SIMD_WIDTH; x += CV_SIMD_WIDTH)
+        {
+            v_int16 low = v_pack(sobelMagnitudeLanes(above + x, center + x, below + x),
+                                 sobelMagnitudeLanes(above + x + quarter, center + x + quarter, below + x + quarter));
+            v_int16 high = v_pack(sobelMagnitudeLanes(above + x + 2 * quarter, center + x + 2 * quarter, below + x + 2 * quarter),
+                                  sobelMagnitudeLanes(above + x + 3 * quarter, center + x + 3 * quarter, below + x + 3 * quarter));
+            v_store(dst + x, v_pack_u(low, high));
+        }
+#endif
+        for (; x < cols; x++)
+        {
+            const int gx = (above[x + 1] + 2 * center[x + 1] + below[x + 1]) - (above[x - 1] + 2 * center[x - 1] + below[x - 1]);
+            const int gy = (below[x - 1] + 2 * below[x] + below[x + 1]) - (above[x - 1] + 2 * above[x] + above[x + 1]);
+            dst[x] = cv::saturate_cast<uchar>(std::sqrt(static_cast<float>(gx * gx + gy * gy)));
+        }
+    }
+}
 
 // Constructor: sets the node's display name and generates a unique ID
 EdgeDetectionNode::EdgeDetectionNode(const std::string &name)
@@ -14,40 +100,242 @@ EdgeDetectionNode::EdgeDetectionNode(const std::string &name)
 void EdgeDetectionNode::setInput(const cv::Mat &input)
 {
     inputImage = input;
+    invalidate(); // Cheap to rerun when the pixels are unchanged: the gradients stay cached
+
+    // The graph hands the same image over again on every run, so compare contents
+    uint64_t hash = ResultCache::hashImage(input);
+    if (hash != inputHash || inputVersion == 0)
+    {
+        inputHash = hash;
+        inputVersion++;
+    }
 }
 
-// Main processing function to apply edge detection
-void EdgeDetectionNode::process()
+const cv::Mat &EdgeDetectionNode::getGrayImage()
 {
-    if (inputImage.empty())
+    if (grayVersion != inputVersion)
     {
-        std::cerr << "No input image for EdgeDetectionNode: " << name << std::endl;
+        // Convert to grayscale if needed
+        if (inputImage.channels() != 1)
+        {
+            cv::cvtColor(inputImage, grayImage, cv::COLOR_BGR2GRAY);
+        }
+        else
+        {
+            grayImage = inputImage;
+        }
+        grayVersion = inputVersion;
+    }
+    return grayImage;
+}
+
+// Computes the threshold-independent part of Canny the way cv::Canny does with its default
+// 3x3 aperture and L1 gradient: replicated borders, magnitude |dx| + |dy| and non-maximum
+// suppression along the gradient direction quantized to 0, 45, 90 or 135 degrees.
+void EdgeDetectionNode::updateGradients()
+{
+    if (gradientVersion == inputVersion)
+        return;
+
+    const cv::Mat &gray = getGrayImage();
+    cv::Mat dx, dy;
+    cv::Sobel(gray, dx, CV_16S, 1, 0, 3, 1, 0, cv::BORDER_REPLICATE);
+    cv::Sobel(gray, dy, CV_16S, 0, 1, 3, 1, 0, cv::BORDER_REPLICATE);
+
+    const int rows = gray.rows;
+    const int cols = gray.cols;
+
+    // One column of zeros on each side, so neighbours outside the image never win
+    cv::Mat magnitude(rows, cols + 2, CV_32S, cv::Scalar(0));
+    cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range &band)
+                      {
+        for (int y = band.start; y < band.end; y++)
+        {
+            const short *dxRow = dx.ptr<short>(y);
+            const short *dyRow = dy.ptr<short>(y);
+            int *magnitudeRow = magnitude.ptr<int>(y) + 1;
+            for (int x = 0; x < cols; x++)
+            {
+                magnitudeRow[x] = std::abs(dxRow[x]) + std::abs(dyRow[x]);
+            }
+        } });
+
+    cv::Mat maxima(rows, cols, CV_8U);
+    const std::vector<int> zeroRow(cols + 2, 0);
+    const int tan22 = static_cast<int>(0.4142135623730950488016887242097 * (1 << 15) + 0.5);
+    cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range &band)
+                      {
+        for (int y = band.start; y < band.end; y++)
+        {
+            const short *dxRow = dx.ptr<short>(y);
+            const short *dyRow = dy.ptr<short>(y);
+            const int *previous = (y > 0 ? magnitude.ptr<int>(y - 1) : zeroRow.data()) + 1;
+            const int *current = magnitude.ptr<int>(y) + 1;
+            const int *next = (y + 1 < rows ? magnitude.ptr<int>(y + 1) : zeroRow.data()) + 1;
+            uchar *maximaRow = maxima.ptr<uchar>(y);
+
+            for (int x = 0; x < cols; x++)
+            {
+                const int m = current[x];
+                const int gx = std::abs(dxRow[x]);
+                const int gy = std::abs(dyRow[x]) << 15;
+                const int tan22x = gx * tan22;
+                bool isMaximum;
+
+                if (gy < tan22x)
+                {
+                    isMaximum = m > current[x - 1] && m >= current[x + 1]; // Horizontal gradient
+                }
+                else if (gy > tan22x + (gx << 16))
+                {
+                    isMaximum = m > previous[x] && m >= next[x]; // Vertical gradient
+                }
+                else
+                {
+                    const int s = (dxRow[x] ^ dyRow[x]) < 0 ? -1 : 1; // Diagonal gradient
+                    isMaximum = m > previous[x - s] && m > next[x + s];
+                }
+                maximaRow[x] = isMaximum ? 1 : 0;
+            }
+        } });
+
+    gradientMagnitude = magnitude.colRange(1, cols + 1);
+    localMaxima = maxima;
+    gradientVersion = inputVersion;
+}
+
+// Each row band keeps a rolling window of three luminance rows, so every source row is
+// converted once per band and the gray and derivative images are never stored.
+void EdgeDetectionNode::applySobelMagnitude(cv::Mat &edges) const
+{
+    const int channels = inputImage.channels();
+    if (inputImage.depth() != CV_8U || (channels != 1 && channels != 3 && channels != 4))
+    {
+        // Uncommon formats go through the library functions in float
+        cv::Mat gray = inputImage, dx, dy, magnitude;
+        if (channels != 1)
+            cv::cvtColor(inputImage, gray, cv::COLOR_BGR2GRAY);
+        cv::Sobel(gray, dx, CV_32F, 1, 0, 3);
+        cv::Sobel(gray, dy, CV_32F, 0, 1, 3);
+        cv::magnitude(dx, dy, magnitude);
+        magnitude.convertTo(edges, CV_8U);
         return;
     }
 
-    // Keep a copy of the original for optional overlay
-    cv::Mat originalColor = inputImage.clone();
+    const int rows = inputImage.rows;
+    const int cols = inputImage.cols;
+    cv::Mat result(rows, cols, CV_8U);
+
+    cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range &band)
+                      {
+        std::vector<int> window(3 * (cols + 2));
+        int *lines[3] = {window.data(), window.data() + (cols + 2), window.data() + 2 * (cols + 2)};
+
+        lumaRow(inputImage.ptr<uchar>(reflect101(band.start - 1, rows)), channels, cols, lines[0]);
+        lumaRow(inputImage.ptr<uchar>(band.start), channels, cols, lines[1]);
+
+        for (int y = band.start; y < band.end; y++)
+        {
+            lumaRow(inputImage.ptr<uchar>(reflect101(y + 1, rows)), channels, cols, lines[2]);
+
+            sobelMagnitudeRow(lines[0] + 1, lines[1] + 1, lines[2] + 1, result.ptr<uchar>(y), cols);
 
-    // Convert to grayscale if needed
-    cv::Mat grayImage;
-    if (inputImage.channels() != 1)
+            // Slide the window down one row
+            std::swap(lines[0], lines[1]);
+            std::swap(lines[1], lines[2]);
+        }
+#if CV_SIMD
+        cv::vx_cleanup();
+#endif
+        });
+
+    edges = result;
+}
+
+void EdgeDetectionNode::applyHysteresis(cv::Mat &edges) const
+{
+    const int low = std::min(cannyThreshold1, cannyThreshold2);
+    const int high = std::max(cannyThreshold1, cannyThreshold2);
+    const int rows = localMaxima.rows;
+    const int cols = localMaxima.cols;
+
+    // Label pass: 255 for strong edges, 1 for weak candidates, 0 otherwise
+    cv::Mat labels(rows, cols, CV_8U);
+    std::vector<int> stack;
+    std::mutex stackMutex;
+    cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range &band)
+                      {
+        std::vector<int> seeds;
+        for (int y = band.start; y < band.end; y++)
+        {
+            const int *magnitudeRow = gradientMagnitude.ptr<int>(y);
+            const uchar *maximaRow = localMaxima.ptr<uchar>(y);
+            uchar *labelRow = labels.ptr<uchar>(y);
+            for (int x = 0; x < cols; x++)
+            {
+                const int m = magnitudeRow[x];
+                uchar label = 0;
+                if (maximaRow[x] && m > low)
+                {
+                    label = m > high ? 255 : 1;
+                    if (label == 255)
+                        seeds.push_back(y * cols + x);
+                }
+                labelRow[x] = label;
+            }
+        }
+        std::lock_guard<std::mutex> lock(stackMutex);
+        stack.insert(stack.end(), seeds.begin(), seeds.end()); });
+
+    // Grow strong edges into connected candidates
+    while (!stack.empty())
     {
-        cv::cvtColor(inputImage, grayImage, cv::COLOR_BGR2GRAY);
+        const int index = stack.back();
+        stack.pop_back();
+        const int y = index / cols;
+        const int x = index % cols;
+        for (int ny = std::max(y - 1, 0); ny <= std::min(y + 1, rows - 1); ny++)
+        {
+            uchar *labelRow = labels.ptr<uchar>(ny);
+            for (int nx = std::max(x - 1, 0); nx <= std::min(x + 1, cols - 1); nx++)
+            {
+                if (labelRow[nx] == 1)
+                {
+                    labelRow[nx] = 255;
+                    stack.push_back(ny * cols + nx);
+                }
+            }
+        }
     }
-    else
+
+    // Candidates never reached from a strong edge are dropped
+    cv::threshold(labels, edges, 128, 255, cv::THRESH_BINARY);
+}
+
+// Main processing function to apply edge detection
+void EdgeDetectionNode::process()
+{
+    if (inputImage.empty())
     {
-        grayImage = inputImage;
+        std::cerr << "No input image for EdgeDetectionNode: " << name << std::endl;
+        return;
     }
 
     // Apply edge detection based on selected method
     cv::Mat edges;
     if (edgeDetectionType == SOBEL)
     {
-        cv::Sobel(grayImage, edges, CV_8U, 1, 1, sobelKernelSize); // Apply Sobel operator
+        cv::Sobel(getGrayImage(), edges, CV_8U, 1, 1, sobelKernelSize); // Apply Sobel operator
     }
     else if (edgeDetectionType == CANNY)
     {
-        cv::Canny(grayImage, edges, cannyThreshold1, cannyThreshold2); // Apply Canny algorithm
+        // Gradients and suppression are reused until the input changes; only hysteresis depends on the thresholds
+        updateGradients();
+        applyHysteresis(edges);
+    }
+    else if (edgeDetectionType == SOBEL_MAGNITUDE)
+    {
+        applySobelMagnitude(edges); // Fused luminance, gradients and magnitude
     }
 
     // If overlay is enabled, mix original color image with edge map
@@ -55,7 +343,7 @@ void EdgeDetectionNode::process()
     {
         cv::Mat colorEdges;
         cv::cvtColor(edges, colorEdges, cv::COLOR_GRAY2BGR);
-        cv::addWeighted(originalColor, 0.7, colorEdges, 0.3, 0, outputImage);
+        cv::addWeighted(inputImage, 0.7, colorEdges, 0.3, 0, outputImage);
     }
     else
     {
@@ -77,12 +365,17 @@ void EdgeDetectionNode::renderUI()
     if (ImGui::RadioButton("Sobel", edgeDetectionType == SOBEL))
     {
         edgeDetectionType = SOBEL;
-        process();
+        markDirty();
     }
     if (ImGui::RadioButton("Canny", edgeDetectionType == CANNY))
     {
         edgeDetectionType = CANNY;
-        process();
+        markDirty();
+    }
+    if (ImGui::RadioButton("Sobel Magnitude", edgeDetectionType == SOBEL_MAGNITUDE))
+    {
+        edgeDetectionType = SOBEL_MAGNITUDE;
+        markDirty();
     }
 
     // Adjustable parameter: kernel size for Sobel
@@ -90,7 +383,7 @@ void EdgeDetectionNode::renderUI()
     {
         if (ImGui::SliderInt("Sobel Kernel Size", &sobelKernelSize, 1, 7))
         {
-            process();
+            markDirty();
         }
     }
 
@@ -99,18 +392,18 @@ void EdgeDetectionNode::renderUI()
     {
         if (ImGui::SliderInt("Canny Threshold 1", &cannyThreshold1, 0, 255))
         {
-            process();
+            markDirty();
         }
         if (ImGui::SliderInt("Canny Threshold 2", &cannyThreshold2, 0, 255))
         {
-            process();
+            markDirty();
         }
     }
 
     // Option to overlay edges on original image
     if (ImGui::Checkbox("Overlay Edges", &overlayEdges))
     {
-        process();
+        markDirty();
     }
 }
 
@@ -120,28 +413,48 @@ cv::Mat EdgeDetectionNode::getOutput() const
     return outputImage;
 }
 
+// Restores a previously computed result image
+void EdgeDetectionNode::setOutput(const cv::Mat &output)
+{
+    outputImage = output;
+}
+
+// Builds the cache key from every detection parameter
+std::string EdgeDetectionNode::getCacheKey() const
+{
+    std::ostringstream key;
+    key << edgeDetectionType << '|' << sobelKernelSize << '|' << cannyThreshold1 << '|' << cannyThreshold2 << '|' << overlayEdges;
+    return key.str();
+}
+
+bool EdgeDetectionNode::getInputImages(std::vector<cv::Mat> &images) const
+{
+    images = {inputImage};
+    return true;
+}
+
 // Manual setters to change settings programmatically
 void EdgeDetectionNode::setEdgeDetectionType(EdgeDetectionType type)
 {
     edgeDetectionType = type;
-    process();
+    markDirty();
 }
 
 void EdgeDetectionNode::setSobelKernelSize(int size)
 {
     sobelKernelSize = size;
-    process();
+    markDirty();
 }
 
 void EdgeDetectionNode::setCannyThresholds(int threshold1, int threshold2)
 {
     cannyThreshold1 = threshold1;
     cannyThreshold2 = threshold2;
-    process();
+    markDirty();
 }
 
 void EdgeDetectionNode::setOverlayEdges(bool overlay)
 {
     overlayEdges = overlay;
-    process();
+    markDirty();
 }
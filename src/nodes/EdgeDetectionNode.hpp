@@ -16,12 +16,35 @@ private:
     int cannyThreshold1 = 50;       // Lower threshold for Canny
     int cannyThreshold2 = 150;      // Upper threshold for Canny
 
+    // Stages that do not depend on the thresholds, kept per input version so that
+    // moving a threshold slider only re-runs hysteresis
+    uint64_t inputVersion = 0;      // Incremented when setInput receives different pixels
+    uint64_t inputHash = 0;         // Content hash of the current input
+    uint64_t grayVersion = 0;       // Input version grayImage was computed from
+    uint64_t gradientVersion = 0;   // Input version the gradient stages were computed from
+    cv::Mat grayImage;              // Grayscale input
+    cv::Mat gradientMagnitude;      // CV_32S, |dx| + |dy| of the 3x3 Sobel gradients
+    cv::Mat localMaxima;            // CV_8U, 1 where the magnitude survives non-maximum suppression
+
+    // Returns the grayscale input, converting only if the input changed
+    const cv::Mat &getGrayImage();
+
+    // Recomputes gradient magnitude and non-maximum suppression if the input changed
+    void updateGradients();
+
+    // Canny's threshold-dependent stage: double thresholding plus hysteresis over the cached gradients
+    void applyHysteresis(cv::Mat &edges) const;
+
+    // Gradient magnitude of the luminance in one pass over the input, without intermediate images
+    void applySobelMagnitude(cv::Mat &edges) const;
+
 public:
     // Enum to switch between Sobel and Canny algorithms
     enum EdgeDetectionType
     {
         SOBEL,
-        CANNY
+        CANNY,
+        SOBEL_MAGNITUDE // 8-bit |G| of the 3x3 Sobel gradients of the luminance
     };
     EdgeDetectionType edgeDetectionType = SOBEL;
 
@@ -40,6 +63,15 @@ public:
     // Retrieve processed image
     cv::Mat getOutput() const override;
 
+    // Restore a cached output image
+    void setOutput(const cv::Mat &output) override;
+
+    // Serialize the detection parameters for the graph's result cache
+    std::string getCacheKey() const override;
+
+    // The input image, hashed into the cache key when it was set directly
+    bool getInputImages(std::vector<cv::Mat> &images) const override;
+
     // Manual configuration methods
     void setEdgeDetectionType(EdgeDetectionType type);
     void setSobelKernelSize(int size);
@@ -1,6 +1,8 @@
 #include "ImageInputNode.hpp"
 #include <opencv2/opencv.hpp>
 #include <iostream>
+#include <filesystem>
+#include <sstream>
 
 // Constructor initializes name and file path
 ImageInputNode::ImageInputNode(const std::string& name, const std::string& filePath)
@@ -22,6 +24,28 @@ void ImageInputNode::setOutput(const cv::Mat& newOutput) {
     output = newOutput;  
 }
 
+// Identify the loaded image by path, modification time and size
+std::string ImageInputNode::getCacheKey() const {
+    std::error_code error;
+    auto modified = std::filesystem::last_write_time(filePath, error);
+    if (error) {
+        return "";  // Missing file: let process() report the failure
+    }
+    auto size = std::filesystem::file_size(filePath, error);
+    if (error) {
+        return "";
+    }
+
+    std::ostringstream key;
+    key << filePath << '|' << modified.time_since_epoch().count() << '|' << size;
+    return key.str();
+}
+
+bool ImageInputNode::getInputImages(std::vector<cv::Mat>& images) const {
+    images.clear();
+    return true;
+}
+
 // Return the current output (original or modified)
 cv::Mat ImageInputNode::getOutput() const {
     return output;
@@ -15,8 +15,14 @@ public:
     // Convert current input image to grayscale and store in output
     void convertToGrayscale();
 
-    // Manually set the output image (optional override)
-    void setOutput(const cv::Mat& newOutput);
+    // Manually set the output image (optional override, also used by the result cache)
+    void setOutput(const cv::Mat& newOutput) override;
+
+    // File path plus modification time and size, so edited files are reloaded
+    std::string getCacheKey() const override;
+
+    // Loads its own image, so there are no direct inputs to hash
+    bool getInputImages(std::vector<cv::Mat>& images) const override;
 
     // Retrieve the output image (used by downstream nodes)
     cv::Mat getOutput() const override;
@@ -1,6 +1,11 @@
 #include "NoiseGenerationNode.hpp"
 #include <opencv2/opencv.hpp>
 #include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <cfloat>
+#include <mutex>
+#include <cmath>
 
 NoiseGeneratorNode::NoiseGeneratorNode(const std::string& id, const std::string& name) {
     this->id = id;
@@ -13,6 +18,7 @@ NoiseGeneratorNode::NoiseGeneratorNode(const std::string& id, const std::string&
     setOctaves(3);
     setPersistence(0.5f);
     useAsDisplacement = false;
+    fastNoiseLite.SetSeed(seed);
 }
 
 void NoiseGeneratorNode::setNoiseType(NoiseType type) {
@@ -28,95 +34,409 @@ void NoiseGeneratorNode::setNoiseType(NoiseType type) {
             fastNoiseLite.SetNoiseType(FastNoiseLite::NoiseType_Cellular);
             break;
     }
+    markDirty();
 }
 
 void NoiseGeneratorNode::setInput(const cv::Mat& input) {
     inputImage = input;
+    invalidate();  // A new input must be processed on the next evaluation
 }
 
 void NoiseGeneratorNode::setScale(float scale) {
     this->scale = std::max(0.001f, scale);
     fastNoiseLite.SetFrequency(this->scale);
+    markDirty();
 }
 
 void NoiseGeneratorNode::setOctaves(int octaves) {
     this->octaves = std::clamp(octaves, 1, 10);
     fastNoiseLite.SetFractalOctaves(this->octaves);
+    markDirty();
 }
 
 void NoiseGeneratorNode::setPersistence(float persistence) {
     this->persistence = std::clamp(persistence, 0.0f, 1.0f);
     fastNoiseLite.SetFractalGain(this->persistence);
+    markDirty();
 }
 
 void NoiseGeneratorNode::setUseAsDisplacement(bool use) {
     useAsDisplacement = use;
+    markDirty();
 }
 
-void NoiseGeneratorNode::process() {
-    if (inputImage.empty()) return;
+void NoiseGeneratorNode::setDisplacementStrength(float strength) {
+    displacementStrength = std::max(0.0f, strength);
+    markDirty();
+}
 
-    generateNoise();
+void NoiseGeneratorNode::setNormalization(Normalization mode) {
+    normalization = mode;
+    markDirty();
+}
+
+void NoiseGeneratorNode::setCellularDistanceFunction(FastNoiseLite::CellularDistanceFunction function) {
+    cellularDistance = function;
+    fastNoiseLite.SetCellularDistanceFunction(function);
+    markDirty();
+}
+
+void NoiseGeneratorNode::setCellularReturnType(FastNoiseLite::CellularReturnType returnType) {
+    cellularReturn = returnType;
+    fastNoiseLite.SetCellularReturnType(returnType);
+    markDirty();
+}
 
-    cv::Mat inputFloat;
-    inputImage.convertTo(inputFloat, CV_32FC3, 1.0 / 255.0);
+void NoiseGeneratorNode::setSeed(int seed) {
+    this->seed = seed;
+    fastNoiseLite.SetSeed(seed);
+    markDirty();
+}
 
-    cv::Mat noiseResized;
-    cv::resize(output, noiseResized, inputImage.size());
+void NoiseGeneratorNode::setAnimated(bool animated) {
+    this->animated = animated;
+    markDirty();
+}
 
-    if (useAsDisplacement) {
-        float strength = 20.0f;
-        cv::Mat displacementMap;
-        cv::merge(std::vector<cv::Mat>{noiseResized, noiseResized, noiseResized}, displacementMap);
-        displacementMap.convertTo(displacementMap, CV_32FC3);
-
-        cv::Mat mapX(inputImage.size(), CV_32FC1);
-        cv::Mat mapY(inputImage.size(), CV_32FC1);
-
-        for (int y = 0; y < inputImage.rows; ++y) {
-            for (int x = 0; x < inputImage.cols; ++x) {
-                float displacement = (displacementMap.at<cv::Vec3f>(y, x)[0] - 0.5f) * 2.0f * strength;
-                mapX.at<float>(y, x) = static_cast<float>(x) + displacement;
-                mapY.at<float>(y, x) = static_cast<float>(y) + displacement;
+void NoiseGeneratorNode::setTime(float time) {
+    this->time = time;
+    markDirty();
+}
+
+void NoiseGeneratorNode::setOffset(int x, int y) {
+    offsetX = x;
+    offsetY = y;
+    markDirty();
+}
+
+void NoiseGeneratorNode::setTileCacheBudget(size_t bytes) {
+    if (bytes == 0) {
+        tileCache.reset();
+    } else if (tileCache) {
+        tileCache->setBudget(bytes);
+    } else {
+        tileCache = std::make_unique<ResultCache>(bytes);
+    }
+}
+
+ResultCache::Stats NoiseGeneratorNode::getTileCacheStats() const {
+    return tileCache ? tileCache->getStats() : ResultCache::Stats();
+}
+
+namespace {
+    // In the color path the noise adds at most this much on top of an input in [0, 1]
+    constexpr float colorNoiseStrength = 0.2f;
+
+    // BORDER_REFLECT (fedcba|abcdef|fedcba) index into [0, length), for any offset
+    inline int reflectIndex(int index, int length) {
+        if (length == 1) return 0;
+        const int period = 2 * length;
+        index %= period;
+        if (index < 0) index += period;
+        return index < length ? index : period - 1 - index;
+    }
+
+    // Rounds towards negative infinity, so tiles left of or above the origin are numbered correctly
+    inline int floorDiv(int value, int divisor) {
+        int quotient = value / divisor;
+        return (value % divisor != 0 && value < 0) ? quotient - 1 : quotient;
+    }
+}
+
+// Each output pixel is displaced diagonally by (noise - 0.5) * 2 * strength and sampled
+// bilinearly from the source, with reflected borders like the cv::remap call this replaces.
+// Offsets are computed on the fly, so no displacement or coordinate maps are allocated.
+void NoiseGeneratorNode::applyDisplacement(const cv::Mat& source) {
+    const int rows = source.rows;
+    const int cols = source.cols;
+    const int channels = source.channels();
+    cv::Mat result(source.size(), source.type());
+
+    cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range& band) {
+        for (int y = band.start; y < band.end; ++y) {
+            const float* noiseRow = noiseField.ptr<float>(y);
+            uchar* dst = result.ptr<uchar>(y);
+
+            for (int x = 0; x < cols; ++x) {
+                float displacement = (noiseRow[x] - 0.5f) * 2.0f * displacementStrength;
+                float sx = static_cast<float>(x) + displacement;
+                float sy = static_cast<float>(y) + displacement;
+                int x0 = static_cast<int>(std::floor(sx));
+                int y0 = static_cast<int>(std::floor(sy));
+                float wx = sx - x0;
+                float wy = sy - y0;
+
+                const uchar* top = source.ptr<uchar>(reflectIndex(y0, rows));
+                const uchar* bottom = source.ptr<uchar>(reflectIndex(y0 + 1, rows));
+                const int left = reflectIndex(x0, cols) * channels;
+                const int right = reflectIndex(x0 + 1, cols) * channels;
+
+                for (int c = 0; c < channels; ++c) {
+                    float upper = top[left + c] + wx * (top[right + c] - top[left + c]);
+                    float lower = bottom[left + c] + wx * (bottom[right + c] - bottom[left + c]);
+                    dst[x * channels + c] = cv::saturate_cast<uchar>(upper + wy * (lower - upper));
+                }
             }
         }
+    });
+
+    output = result;
+}
+
+void NoiseGeneratorNode::process() {
+    if (inputImage.empty()) return;
+
+    generateNoise();
 
-        cv::Mat warped;
-        cv::remap(inputFloat, warped, mapX, mapY, cv::INTER_LINEAR, cv::BORDER_REFLECT);
-        warped.convertTo(output, CV_8UC3, 255.0);
+    if (useAsDisplacement) {
+        cv::Mat source = inputImage;
+        if (source.depth() != CV_8U) {
+            inputImage.convertTo(source, CV_8U);
+        }
+        applyDisplacement(source);
     } else {
+        cv::Mat inputFloat;
+        inputImage.convertTo(inputFloat, CV_32FC3, 1.0 / 255.0);
+
         cv::Mat noiseColor;
-        cv::merge(std::vector<cv::Mat>{noiseResized, noiseResized, noiseResized}, noiseColor);
+        cv::merge(std::vector<cv::Mat>{noiseField, noiseField, noiseField}, noiseColor);
         noiseColor.convertTo(noiseColor, CV_32FC3);
 
-        float noiseStrength = 0.2f;
-        cv::Mat combined = inputFloat + noiseColor * noiseStrength;
-        cv::normalize(combined, combined, 0, 1, cv::NORM_MINMAX);
-        combined.convertTo(output, CV_8UC3, 255.0);
+        cv::Mat combined = inputFloat + noiseColor * colorNoiseStrength;
+        if (normalization == Normalization::Analytic) {
+            // Input in [0, 1] plus noise in [0, strength]: a fixed range, so no global pass is needed
+            combined.convertTo(output, CV_8UC3, 255.0 / (1.0 + colorNoiseStrength));
+        } else {
+            cv::normalize(combined, combined, 0, 1, cv::NORM_MINMAX);
+            combined.convertTo(output, CV_8UC3, 255.0);
+        }
+    }
+}
+
+float NoiseGeneratorNode::sampleNoise(float x, float y) const {
+    return animated ? fastNoiseLite.GetNoise(x, y, time) : fastNoiseLite.GetNoise(x, y);
+}
+
+// Perlin and OpenSimplex2 are scaled by FastNoiseLite to [-1, 1]. Cellular noise returns
+// a feature distance minus 1 (or a hashed cell value in [-1, 1]), so its range depends on
+// the distance function and return type. Feature points are jittered by at most 0.437
+// (2D) or 0.396 (3D) from their cell centres. A sample lies within half a cell of its own
+// centre and within one cell of a second centre, which bounds the nearest and
+// second-nearest distances. Fractal sums divide by their total amplitude, so they stay
+// within the same bounds.
+void NoiseGeneratorNode::getAnalyticRange(float& low, float& high) const {
+    low = -1.0f;
+    high = 1.0f;
+    if (noiseType != NoiseType::Worley || cellularReturn == FastNoiseLite::CellularReturnType_CellValue) {
+        return;
+    }
+
+    const float jitter = animated ? 0.39614353f : 0.43701595f;
+    const float halfDiagonal = animated ? 0.8660254f : 0.70710678f;   // Farthest point of a cell from its centre
+    const float halfPerimeter = animated ? 1.5f : 1.0f;               // The same in Manhattan distance
+    const float jitterManhattan = jitter * (animated ? 1.7320508f : 1.41421356f);
+
+    // Largest nearest (first) and second-nearest (second) distance under the metric
+    const float euclideanFirst = halfDiagonal + jitter;
+    const float euclideanSecond = std::max(euclideanFirst, 1.0f + jitter);
+    const float manhattanFirst = halfPerimeter + jitterManhattan;
+    const float manhattanSecond = std::max(manhattanFirst, 1.0f + jitterManhattan);
+    float first = euclideanFirst;
+    float second = euclideanSecond;
+    switch (cellularDistance) {
+        case FastNoiseLite::CellularDistanceFunction_Euclidean:
+            break;
+        case FastNoiseLite::CellularDistanceFunction_EuclideanSq:
+            first = euclideanFirst * euclideanFirst;
+            second = euclideanSecond * euclideanSecond;
+            break;
+        case FastNoiseLite::CellularDistanceFunction_Manhattan:
+            first = manhattanFirst;
+            second = manhattanSecond;
+            break;
+        case FastNoiseLite::CellularDistanceFunction_Hybrid:
+            first = manhattanFirst + euclideanFirst * euclideanFirst;
+            second = manhattanSecond + euclideanSecond * euclideanSecond;
+            break;
+    }
+
+    switch (cellularReturn) {
+        case FastNoiseLite::CellularReturnType_Distance:
+            high = first - 1.0f;
+            break;
+        case FastNoiseLite::CellularReturnType_Distance2Add:
+            high = (first + second) * 0.5f - 1.0f;
+            break;
+        case FastNoiseLite::CellularReturnType_Distance2Mul:
+            high = first * second * 0.5f - 1.0f;
+            break;
+        case FastNoiseLite::CellularReturnType_Distance2Div:
+            high = 0.0f;  // The nearest distance never exceeds the second nearest
+            break;
+        default:
+            high = second - 1.0f;  // Distance2, and Distance2Sub since the difference is at most the second
+            break;
     }
 }
 
+// GetNoise is a pure function of the coordinates, so the field is filled in parallel and
+// every sample is exactly what the sequential loop produced. The value range is gathered
+// while filling, which saves the extra pass cv::normalize would make.
 void NoiseGeneratorNode::generateNoise() {
-    int width = inputImage.cols;
-    int height = inputImage.rows;
-    output = cv::Mat(height, width, CV_32F);
-
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            float nx = static_cast<float>(x);
-            float ny = static_cast<float>(y);
-            float noiseVal = fastNoiseLite.GetNoise(nx, ny);
-            output.at<float>(y, x) = noiseVal;
+    noiseField = cv::Mat(inputImage.rows, inputImage.cols, CV_32F);
+
+    float low = FLT_MAX;
+    float high = -FLT_MAX;
+    if (tileCache) {
+        fillNoiseFromTiles(low, high);
+    } else {
+        fillNoise(low, high);
+    }
+
+    if (normalization == Normalization::Analytic) {
+        float noiseMin, noiseMax;
+        getAnalyticRange(noiseMin, noiseMax);
+        const float rangeScale = 1.0f / (noiseMax - noiseMin);
+        cv::parallel_for_(cv::Range(0, noiseField.rows), [&](const cv::Range& rows) {
+            for (int y = rows.start; y < rows.end; ++y) {
+                float* row = noiseField.ptr<float>(y);
+                for (int x = 0; x < noiseField.cols; ++x) {
+                    row[x] = std::clamp((row[x] - noiseMin) * rangeScale, 0.0f, 1.0f);
+                }
+            }
+        });
+        return;
+    }
+
+    // Same scale and shift cv::normalize(output, output, 0, 1, NORM_MINMAX) derives
+    double range = static_cast<double>(high) - low;
+    double normalizeScale = range > DBL_EPSILON ? 1.0 / range : 0.0;
+    double normalizeShift = -low * normalizeScale;
+    noiseField.convertTo(noiseField, -1, normalizeScale, normalizeShift);
+}
+
+void NoiseGeneratorNode::fillNoise(float& low, float& high) {
+    std::mutex rangeMutex;
+
+    cv::parallel_for_(cv::Range(0, noiseField.rows), [&](const cv::Range& rows) {
+        float bandLow = FLT_MAX;
+        float bandHigh = -FLT_MAX;
+        for (int y = rows.start; y < rows.end; ++y) {
+            float* row = noiseField.ptr<float>(y);
+            float ny = static_cast<float>(y + offsetY);
+            for (int x = 0; x < noiseField.cols; ++x) {
+                float noiseVal = sampleNoise(static_cast<float>(x + offsetX), ny);
+                row[x] = noiseVal;
+                bandLow = std::min(bandLow, noiseVal);
+                bandHigh = std::max(bandHigh, noiseVal);
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(rangeMutex);
+        low = std::min(low, bandLow);
+        high = std::max(high, bandHigh);
+    });
+}
+
+// Tiles lie on a fixed grid in noise space, so any region, at any offset, is covered by
+// tiles that earlier frames or overlapping renders may already have produced. Each tile
+// is fetched or generated by one worker and copied into its own part of the field.
+void NoiseGeneratorNode::fillNoiseFromTiles(float& low, float& high) {
+    const int firstTileX = floorDiv(offsetX, tileSize);
+    const int firstTileY = floorDiv(offsetY, tileSize);
+    const int lastTileX = floorDiv(offsetX + noiseField.cols - 1, tileSize);
+    const int lastTileY = floorDiv(offsetY + noiseField.rows - 1, tileSize);
+    const int tilesAcross = lastTileX - firstTileX + 1;
+    const int tileCount = tilesAcross * (lastTileY - firstTileY + 1);
+    std::mutex rangeMutex;
+
+    cv::parallel_for_(cv::Range(0, tileCount), [&](const cv::Range& tiles) {
+        float tilesLow = FLT_MAX;
+        float tilesHigh = -FLT_MAX;
+        for (int i = tiles.start; i < tiles.end; ++i) {
+            const int tileX = firstTileX + i % tilesAcross;
+            const int tileY = firstTileY + i / tilesAcross;
+            cv::Mat tile = getTile(tileX, tileY);
+
+            // Overlap of the tile and the field, in field coordinates
+            const int x0 = std::max(tileX * tileSize - offsetX, 0);
+            const int y0 = std::max(tileY * tileSize - offsetY, 0);
+            const int x1 = std::min((tileX + 1) * tileSize - offsetX, noiseField.cols);
+            const int y1 = std::min((tileY + 1) * tileSize - offsetY, noiseField.rows);
+
+            for (int y = y0; y < y1; ++y) {
+                const float* src = tile.ptr<float>(y + offsetY - tileY * tileSize) + (offsetX - tileX * tileSize);
+                float* dst = noiseField.ptr<float>(y);
+                for (int x = x0; x < x1; ++x) {
+                    dst[x] = src[x];
+                    tilesLow = std::min(tilesLow, src[x]);
+                    tilesHigh = std::max(tilesHigh, src[x]);
+                }
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(rangeMutex);
+        low = std::min(low, tilesLow);
+        high = std::max(high, tilesHigh);
+    });
+}
+
+cv::Mat NoiseGeneratorNode::getTile(int tileX, int tileY) {
+    const std::string key = getTileKey(tileX, tileY);
+    cv::Mat tile;
+    if (tileCache->lookup(key, tile)) {
+        return tile;
+    }
+
+    tile = cv::Mat(tileSize, tileSize, CV_32F);
+    for (int y = 0; y < tileSize; ++y) {
+        float* row = tile.ptr<float>(y);
+        float ny = static_cast<float>(tileY * tileSize + y);
+        for (int x = 0; x < tileSize; ++x) {
+            row[x] = sampleNoise(static_cast<float>(tileX * tileSize + x), ny);
         }
     }
 
-    cv::normalize(output, output, 0.0f, 1.0f, cv::NORM_MINMAX);
+    tileCache->insert(key, tile);
+    return tile;
+}
+
+// Everything that changes a raw sample: normalization and the output mode work on the
+// assembled field, so tiles are shared between them
+std::string NoiseGeneratorNode::getTileKey(int tileX, int tileY) const {
+    std::ostringstream key;
+    key.precision(9);
+    key << seed << '|' << static_cast<int>(noiseType) << '|' << scale << '|' << octaves << '|' << persistence << '|'
+        << cellularDistance << ',' << cellularReturn;
+    if (animated) {
+        key << "|t" << time;
+    }
+    key << '|' << tileX << ',' << tileY;
+    return key.str();
 }
 
 cv::Mat NoiseGeneratorNode::getOutput() const {
     return output;
 }
 
+void NoiseGeneratorNode::setOutput(const cv::Mat& output) {
+    this->output = output;
+}
+
+std::string NoiseGeneratorNode::getCacheKey() const {
+    std::ostringstream key;
+    key.precision(9);
+    key << static_cast<int>(noiseType) << '|' << scale << '|' << octaves << '|' << persistence << '|' << useAsDisplacement
+        << '|' << displacementStrength << '|' << static_cast<int>(normalization) << '|' << seed << '|' << animated
+        << '|' << time << '|' << offsetX << ',' << offsetY << '|' << cellularDistance << ',' << cellularReturn;
+    return key.str();
+}
+
+bool NoiseGeneratorNode::getInputImages(std::vector<cv::Mat>& images) const {
+    images = {inputImage};
+    return true;
+}
+
 void NoiseGeneratorNode::renderUI() {
     std::cout << "Rendering UI for Noise Generator Node: " << name << std::endl;
 }
@@ -2,13 +2,21 @@
 
 #include "../libs/FastNoiseLite.h"
 #include "../graph/Node.hpp"
+#include "../graph/ResultCache.hpp"
 #include <opencv2/opencv.hpp>
+#include <memory>
 #include <string>
 
 class NoiseGeneratorNode : public Node {
 public:
     enum class NoiseType { Perlin, Simplex, Worley };
 
+    // How raw noise values are mapped to [0, 1]
+    enum class Normalization {
+        MinMax,   // Stretch the observed range of the whole image (legacy; needs the full image)
+        Analytic  // Fixed mapping from the noise's theoretical range; every pixel independent
+    };
+
     NoiseGeneratorNode(const std::string& id, const std::string& name);
 
     // Config setters
@@ -17,15 +25,48 @@ public:
     void setOctaves(int octaves);            // Number of fractal layers
     void setPersistence(float persistence);  // Amplitude scaling across octaves
     void setUseAsDisplacement(bool use);     // Enable displacement mode
+    void setDisplacementStrength(float strength);  // Largest offset in pixels in displacement mode
+    void setNormalization(Normalization mode);     // MinMax (default) or Analytic
+
+    // Worley noise only; the defaults are FastNoiseLite's (EuclideanSq distance, Distance return)
+    void setCellularDistanceFunction(FastNoiseLite::CellularDistanceFunction function);
+    void setCellularReturnType(FastNoiseLite::CellularReturnType returnType);
+
+    // Animation and tiling
+    void setSeed(int seed);
+    void setAnimated(bool animated);         // Sample 3D noise at (x, y, time) instead of 2D noise
+    void setTime(float time);                // Third noise coordinate in animated mode
+    void setOffset(int x, int y);            // Noise-space position of the top-left pixel, for panning
+    void setTileCacheBudget(size_t bytes);   // Memory kept for generated tiles; 0 (the default) disables the tile cache
+    ResultCache::Stats getTileCacheStats() const;
 
     void setInput(const cv::Mat& input) override;
     cv::Mat getOutput() const override;
+    void setOutput(const cv::Mat& output) override;  // Restores a cached result
+    std::string getCacheKey() const override;        // Noise parameters for the result cache
+    bool getInputImages(std::vector<cv::Mat>& images) const override;  // The displacement source
 
     void process() override;
     void renderUI() override;
 
 private:
-    void generateNoise();  // Generates procedural noise into `output`
+    void generateNoise();  // Generates procedural noise into `noiseField`
+
+    // Fills `noiseField` with raw noise and reports its range, directly or from cached tiles
+    void fillNoise(float& low, float& high);
+    void fillNoiseFromTiles(float& low, float& high);
+
+    // Raw noise of the tile at (tileX, tileY) in tile units, from the cache or freshly generated
+    cv::Mat getTile(int tileX, int tileY);
+    std::string getTileKey(int tileX, int tileY) const;
+
+    float sampleNoise(float x, float y) const;  // 2D or 3D sample at noise-space pixel coordinates
+
+    // Bounds on raw samples for the current noise type and cellular settings, used by Analytic mode
+    void getAnalyticRange(float& low, float& high) const;
+
+    // Warps the input by the noise field in one pass, sampling the source directly
+    void applyDisplacement(const cv::Mat& source);
 
     // Parameters
     NoiseType noiseType = NoiseType::Perlin;
@@ -33,11 +74,26 @@ private:
     int octaves = 3;
     float persistence = 0.5f;
     bool useAsDisplacement = false;
+    float displacementStrength = 20.0f;
+    Normalization normalization = Normalization::MinMax;
+    FastNoiseLite::CellularDistanceFunction cellularDistance = FastNoiseLite::CellularDistanceFunction_EuclideanSq;
+    FastNoiseLite::CellularReturnType cellularReturn = FastNoiseLite::CellularReturnType_Distance;
+    int seed = 1337;  // FastNoiseLite's default seed
+    bool animated = false;
+    float time = 0.0f;
+    int offsetX = 0;
+    int offsetY = 0;
 
     // Internal state
     cv::Mat inputImage;
+    cv::Mat noiseField;  // CV_32F noise at the input size, normalized to [0, 1]
     cv::Mat output;
 
     // Noise engine
     FastNoiseLite fastNoiseLite;
+
+    // Raw noise tiles keyed on every setting that affects their samples, so re-rendering
+    // overlapping regions, panning or revisiting a frame reuses them; null until a budget is set
+    static constexpr int tileSize = 128;
+    std::unique_ptr<ResultCache> tileCache;
 };
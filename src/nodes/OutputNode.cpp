@@ -12,6 +12,7 @@ OutputNode::OutputNode(const std::string& name, const std::string& path, const s
 
 void OutputNode::setInput(const cv::Mat& input) {
     inputImage = input;
+    invalidate();  // A new input must be written on the next evaluation
 }
 
 void OutputNode::process() {
@@ -47,18 +48,22 @@ void OutputNode::process() {
 void OutputNode::renderUI() {
     ImGui::Text("🖼️ Output Node: %s", name.c_str());
     
-    ImGui::SliderInt("Quality", &quality, 1, 100);
+    if (ImGui::SliderInt("Quality", &quality, 1, 100)) {
+        markDirty();
+    }
 
     static char pathBuffer[256];
     strcpy(pathBuffer, savePath.c_str());
     if (ImGui::InputText("Save Path", pathBuffer, IM_ARRAYSIZE(pathBuffer))) {
         savePath = std::string(pathBuffer);
+        markDirty();
     }
 
     const char* formats[] = { "jpg", "png" };
     static int formatIdx = (type == "png") ? 1 : 0;
     if (ImGui::Combo("Format", &formatIdx, formats, IM_ARRAYSIZE(formats))) {
         type = formats[formatIdx];
+        markDirty();
     }
 
     if (ImGui::Button("💾 Save Image")) {
@@ -87,4 +92,5 @@ cv::Mat OutputNode::getOutput() const {
 
 void OutputNode::settype(const std::string &stype) {
     this->type = std::move(stype);
+    markDirty();
 }
@@ -1,8 +1,11 @@
 #include "ThresholdNode.hpp"
+#include "../graph/HistogramService.hpp"
 #include <opencv2/opencv.hpp>
 #include <iostream>
 #include <imgui.h>
 #include <algorithm>  
+#include <sstream>
+#include <cmath>
 
 // Constructor initializes the node with a given name
 ThresholdNode::ThresholdNode(const std::string& name) {
@@ -13,6 +16,8 @@ ThresholdNode::ThresholdNode(const std::string& name) {
 // Sets the input image for processing
 void ThresholdNode::setInput(const cv::Mat& input) {
     inputImage = input;
+    inputVersion = HistogramService::nextVersion();
+    invalidate();  // A new input must be thresholded on the next evaluation
 }
 
 // Processes the input image based on the selected thresholding method
@@ -25,6 +30,7 @@ void ThresholdNode::process() {
     // Convert the image to grayscale if it's not already
     if (inputImage.channels() != 1) {
         cv::cvtColor(inputImage, inputImage, cv::COLOR_BGR2GRAY);
+        inputVersion = HistogramService::nextVersion();
     }
 
     // Apply the selected thresholding method
@@ -34,13 +40,19 @@ void ThresholdNode::process() {
             cv::threshold(inputImage, outputImage, thresholdValue, maxThresholdValue, cv::THRESH_BINARY);
             break;
         case ADAPTIVE:
-            // Apply adaptive thresholding
-            cv::adaptiveThreshold(inputImage, outputImage, maxThresholdValue, cv::ADAPTIVE_THRESH_MEAN_C,
-                                  cv::THRESH_BINARY, blockSize, C);
+        case SAUVOLA:
+        case NIBLACK:
+            // Apply local thresholding from the window statistics
+            applyLocalThreshold();
             break;
         case OTSU:
-            // Apply Otsu's thresholding
-            cv::threshold(inputImage, outputImage, 0, maxThresholdValue, cv::THRESH_BINARY | cv::THRESH_OTSU);
+            // Apply Otsu's thresholding; the level comes from the shared histogram the UI also plots
+            if (inputImage.type() == CV_8UC1) {
+                int level = HistogramService::otsuThreshold(getInputHistogram());
+                cv::threshold(inputImage, outputImage, level, maxThresholdValue, cv::THRESH_BINARY);
+            } else {
+                cv::threshold(inputImage, outputImage, 0, maxThresholdValue, cv::THRESH_BINARY | cv::THRESH_OTSU);
+            }
             break;
         default:
             // Handle invalid thresholding type
@@ -53,10 +65,68 @@ void ThresholdNode::process() {
         std::cerr << "Failed to apply thresholding." << std::endl;
     } else {
         // Log the applied method
-        std::cout << "Threshold applied using " << (thresholdType == BINARY ? "Binary" : 
-                                                     (thresholdType == ADAPTIVE ? "Adaptive" : "Otsu"))
-                  << " method." << std::endl;
+        const char* methodNames[] = {"Binary", "Adaptive", "Otsu", "Sauvola", "Niblack"};
+        std::cout << "Threshold applied using " << methodNames[thresholdType] << " method." << std::endl;
+    }
+}
+
+// Thresholds each pixel against statistics of the blockSize x blockSize window around it.
+// Window sums come from integral images in four lookups, and rows are split into bands
+// processed in parallel.
+void ThresholdNode::applyLocalThreshold() {
+    if (inputImage.depth() != CV_8U) {
+        std::cerr << "Local thresholding requires an 8-bit image in ThresholdNode: " << name << std::endl;
+        return;
     }
+
+    const int rows = inputImage.rows;
+    const int cols = inputImage.cols;
+    const int half = std::max(blockSize, 3) / 2;
+    const bool needsDeviation = thresholdType != ADAPTIVE;
+    const uchar maxValue = cv::saturate_cast<uchar>(maxThresholdValue);
+
+    // Double precision keeps the sums exact for any image size
+    cv::Mat sum, squareSum;
+    if (needsDeviation) {
+        cv::integral(inputImage, sum, squareSum, CV_64F, CV_64F);
+    } else {
+        cv::integral(inputImage, sum, CV_64F);
+    }
+
+    cv::Mat result(inputImage.size(), CV_8U);
+    cv::parallel_for_(cv::Range(0, rows), [&](const cv::Range& band) {
+        for (int y = band.start; y < band.end; y++) {
+            const int top = std::max(y - half, 0);
+            const int bottom = std::min(y + half + 1, rows);
+            const double* sumTop = sum.ptr<double>(top);
+            const double* sumBottom = sum.ptr<double>(bottom);
+            const double* squareTop = needsDeviation ? squareSum.ptr<double>(top) : nullptr;
+            const double* squareBottom = needsDeviation ? squareSum.ptr<double>(bottom) : nullptr;
+            const uchar* src = inputImage.ptr<uchar>(y);
+            uchar* dst = result.ptr<uchar>(y);
+
+            for (int x = 0; x < cols; x++) {
+                const int left = std::max(x - half, 0);
+                const int right = std::min(x + half + 1, cols);
+                const double area = static_cast<double>(bottom - top) * (right - left);
+                const double mean = (sumBottom[right] - sumBottom[left] - sumTop[right] + sumTop[left]) / area;
+
+                double threshold;
+                if (thresholdType == ADAPTIVE) {
+                    // Same test as cv::adaptiveThreshold with ADAPTIVE_THRESH_MEAN_C
+                    threshold = cvRound(mean) - C;
+                } else {
+                    const double squareMean =
+                        (squareBottom[right] - squareBottom[left] - squareTop[right] + squareTop[left]) / area;
+                    const double deviation = std::sqrt(std::max(squareMean - mean * mean, 0.0));
+                    threshold = thresholdType == SAUVOLA ? mean * (1.0 + sauvolaK * (deviation / 128.0 - 1.0))
+                                                         : mean + niblackK * deviation;
+                }
+                dst[x] = src[x] > threshold ? maxValue : 0;
+            }
+        }
+    });
+    outputImage = result;
 }
 
 // Renders the user interface for thresholding settings
@@ -66,45 +136,63 @@ void ThresholdNode::renderUI() {
     // Radio buttons to select thresholding method
     if (ImGui::RadioButton("Binary", thresholdType == BINARY)) {
         thresholdType = BINARY;
-        process(); // Reprocess image when method is changed
+        markDirty(); // Reprocess image when method is changed
     }
     if (ImGui::RadioButton("Adaptive", thresholdType == ADAPTIVE)) {
         thresholdType = ADAPTIVE;
-        process();
+        markDirty();
     }
     if (ImGui::RadioButton("Otsu", thresholdType == OTSU)) {
         thresholdType = OTSU;
-        process();
+        markDirty();
+    }
+    if (ImGui::RadioButton("Sauvola", thresholdType == SAUVOLA)) {
+        thresholdType = SAUVOLA;
+        markDirty();
+    }
+    if (ImGui::RadioButton("Niblack", thresholdType == NIBLACK)) {
+        thresholdType = NIBLACK;
+        markDirty();
     }
 
     // Show additional UI for binary thresholding
     if (thresholdType == BINARY) {
         if (ImGui::SliderInt("Threshold Value", &thresholdValue, 0, maxThresholdValue)) {
-            process(); // Reprocess when threshold value is changed
+            markDirty(); // Reprocess when threshold value is changed
         }
     }
 
-    // Show additional UI for adaptive thresholding
-    if (thresholdType == ADAPTIVE) {
+    // Show additional UI for local thresholding; the cost does not grow with the block size
+    if (thresholdType == ADAPTIVE || thresholdType == SAUVOLA || thresholdType == NIBLACK) {
         // Slider for block size, ensures it is an odd number
-        if (ImGui::SliderInt("Block Size", &blockSize, 3, 21)) {
+        if (ImGui::SliderInt("Block Size", &blockSize, 3, 401)) {
             if (blockSize % 2 == 0) blockSize++; // Ensure odd block size
-            process();
+            markDirty();
         }
+    }
+    if (thresholdType == ADAPTIVE) {
         if (ImGui::SliderInt("C Constant", &C, 1, 10)) {
-            process(); // Reprocess when constant is changed
+            markDirty(); // Reprocess when constant is changed
         }
     }
-
-    // Display histogram of the input image
-    if (!inputImage.empty()) {
-        std::vector<int> histogram(256, 0);
-        // Calculate histogram values
-        for (int i = 0; i < inputImage.rows; i++) {
-            for (int j = 0; j < inputImage.cols; j++) {
-                histogram[inputImage.at<uchar>(i, j)]++;
-            }
+    if (thresholdType == SAUVOLA) {
+        float k = static_cast<float>(sauvolaK);
+        if (ImGui::SliderFloat("k", &k, 0.0f, 1.0f)) {
+            sauvolaK = k;
+            markDirty();
+        }
+    }
+    if (thresholdType == NIBLACK) {
+        float k = static_cast<float>(niblackK);
+        if (ImGui::SliderFloat("k", &k, -1.0f, 1.0f)) {
+            niblackK = k;
+            markDirty();
         }
+    }
+
+    // Display histogram of the input image, computed once per input change
+    if (!inputImage.empty() && inputImage.type() == CV_8UC1) {
+        std::vector<int> histogram = getInputHistogram();
 
         // Convert histogram to float for display
         std::vector<float> histogramFloat(histogram.begin(), histogram.end());
@@ -116,31 +204,86 @@ void ThresholdNode::renderUI() {
     }
 }
 
+// Only binary thresholding qualifies; color input is converted to grayscale first
+bool ThresholdNode::isPointOperation(const cv::Mat& input) const {
+    return thresholdType == BINARY && input.channels() == 1 &&
+           (input.depth() == CV_8U || input.depth() == CV_32F);
+}
+
+// Applies binary thresholding to a row of float samples, matching THRESH_BINARY
+void ThresholdNode::applyPointRow(float* values, int length) const {
+    const float threshold = static_cast<float>(thresholdValue);
+    const float maxValue = static_cast<float>(maxThresholdValue);
+    for (int i = 0; i < length; i++) {
+        values[i] = values[i] > threshold ? maxValue : 0.0f;
+    }
+}
+
+bool ThresholdNode::needsInputWhenFused() const {
+    return true;
+}
+
+// Looks up the input histogram, computing it only if the input changed since the last request
+std::vector<int> ThresholdNode::getInputHistogram() const {
+    return HistogramService::instance().get(inputImage, inputVersion);
+}
+
 // Returns the processed output image
 cv::Mat ThresholdNode::getOutput() const {
     return outputImage;
 }
 
+// Restores a previously computed output image
+void ThresholdNode::setOutput(const cv::Mat& output) {
+    outputImage = output;
+}
+
+// Builds the cache key from every thresholding parameter
+std::string ThresholdNode::getCacheKey() const {
+    std::ostringstream key;
+    key.precision(17);
+    key << thresholdType << '|' << thresholdValue << '|' << maxThresholdValue << '|' << blockSize << '|' << C << '|'
+        << sauvolaK << '|' << niblackK;
+    return key.str();
+}
+
+bool ThresholdNode::getInputImages(std::vector<cv::Mat>& images) const {
+    images = {inputImage};
+    return true;
+}
+
 // Setter for threshold type (e.g., Binary, Adaptive, Otsu)
 void ThresholdNode::setThresholdType(ThresholdType type) {
     thresholdType = type;
-    process(); // Reprocess when threshold type is changed
+    markDirty(); // Reprocess when threshold type is changed
 }
 
 // Setter for threshold value (used in binary thresholding)
 void ThresholdNode::setThresholdValue(int value) {
     thresholdValue = value;
-    process(); // Reprocess when threshold value is changed
+    markDirty(); // Reprocess when threshold value is changed
 }
 
 // Setter for block size (used in adaptive thresholding)
 void ThresholdNode::setBlockSize(int size) {
     blockSize = size;
-    process(); // Reprocess when block size is changed
+    markDirty(); // Reprocess when block size is changed
 }
 
 // Setter for the C constant (used in adaptive thresholding)
 void ThresholdNode::setC(int constant) {
     C = constant;
-    process(); // Reprocess when C constant is changed
+    markDirty(); // Reprocess when C constant is changed
+}
+
+// Setter for the Sauvola k parameter
+void ThresholdNode::setSauvolaK(double k) {
+    sauvolaK = k;
+    markDirty(); // Reprocess when k is changed
+}
+
+// Setter for the Niblack k parameter
+void ThresholdNode::setNiblackK(double k) {
+    niblackK = k;
+    markDirty(); // Reprocess when k is changed
 }
@@ -12,17 +12,25 @@ public:
     // Output image (processed after thresholding)
     cv::Mat outputImage;
 
+    // Replaced with a fresh HistogramService version whenever inputImage changes, so its
+    // cached histogram is recomputed
+    uint64_t inputVersion = 0;
+
     // Thresholding parameters
     int thresholdValue = 128; // Default threshold value for binary thresholding
     int maxThresholdValue = 255;  // Maximum threshold value (for binary and OTSU)
     int blockSize = 11;  // Block size for adaptive thresholding (should be odd)
     int C = 2; // Constant for adaptive thresholding (to adjust the result)
+    double sauvolaK = 0.34; // Sensitivity of Sauvola thresholding to the local standard deviation
+    double niblackK = -0.2; // Weight of the local standard deviation in Niblack thresholding
 
     // Enum representing the type of thresholding to apply
     enum ThresholdType {
         BINARY,    // Binary thresholding
-        ADAPTIVE,  // Adaptive thresholding
-        OTSU       // Otsu's thresholding
+        ADAPTIVE,  // Adaptive thresholding (local mean minus C)
+        OTSU,      // Otsu's thresholding
+        SAUVOLA,   // Sauvola's local thresholding
+        NIBLACK    // Niblack's local thresholding
     };
 
     // Default thresholding method (set to Binary by default)
@@ -43,6 +51,22 @@ public:
     // Get the processed output image
     cv::Mat getOutput() const override;
 
+    // Restore a cached output image
+    void setOutput(const cv::Mat& output) override;
+
+    // Serialize the thresholding parameters for the graph's result cache
+    std::string getCacheKey() const override;
+
+    // The input image, hashed into the cache key when it was set directly
+    bool getInputImages(std::vector<cv::Mat>& images) const override;
+
+    // Binary thresholding of a single-channel 8-bit or float image is a point operation
+    bool isPointOperation(const cv::Mat& input) const override;
+    void applyPointRow(float* values, int length) const override;
+
+    // The UI plots the input histogram, so a fused node still needs its input
+    bool needsInputWhenFused() const override;
+
     // Set the thresholding type (BINARY, ADAPTIVE, or OTSU)
     void setThresholdType(ThresholdType type);
 
@@ -54,4 +78,19 @@ public:
 
     // Set the constant (C) for adaptive thresholding
     void setC(int constant);
+
+    // Set the k parameter of Sauvola thresholding (typically 0.2 to 0.5)
+    void setSauvolaK(double k);
+
+    // Set the k parameter of Niblack thresholding (typically -0.2)
+    void setNiblackK(double k);
+
+private:
+    // Histogram of the current input from the shared HistogramService (8-bit grayscale only)
+    std::vector<int> getInputHistogram() const;
+
+    // Local thresholding (ADAPTIVE, SAUVOLA, NIBLACK) from summed-area tables, so the
+    // cost per pixel does not depend on blockSize. Windows are clamped to the image,
+    // so near the border the statistics cover only the pixels inside it.
+    void applyLocalThreshold();
 };